@@ -0,0 +1,322 @@
+#include "async_frame_writer.h"
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <liburing.h>
+#include <unistd.h>
+
+async_frame_writer::async_frame_writer(size_t         queue_depth,
+                                       image_format_e format)
+  : format{ format }
+  , queue_depth{ queue_depth == 0 ? 1 : queue_depth }
+  , ring{ new struct io_uring }
+  , slots(this->queue_depth) {
+  if(io_uring_queue_init((unsigned)this->queue_depth, ring.get(), 0) == 0) {
+    ring_ready = true;
+  } else {
+    ring.reset();
+  }
+
+  thread = std::thread(&async_frame_writer::worker, this);
+}
+
+async_frame_writer::~async_frame_writer() {
+  flush();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+
+  not_empty.notify_all();
+  thread.join();
+
+  if(ring != nullptr) {
+    io_uring_queue_exit(ring.get());
+  }
+}
+
+framebuffer async_frame_writer::acquire(int32_t width, int32_t height) {
+  return pool.acquire(width, height);
+}
+
+void async_frame_writer::submit(std::string filename, framebuffer image) {
+  std::unique_lock<std::mutex> lock(mutex);
+
+  not_full.wait(lock, [this] { return queue.size() < queue_depth; });
+
+  queue.push_back(frame_s{ std::move(filename), std::move(image) });
+  pending++;
+
+  lock.unlock();
+  not_empty.notify_one();
+}
+
+void async_frame_writer::flush() {
+  std::unique_lock<std::mutex> lock(mutex);
+
+  idle.wait(lock, [this] { return pending == 0; });
+}
+
+size_t async_frame_writer::failures() const {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  return failed_count;
+}
+
+// Queues the rest of the slot's bytes on the ring. Returns false when the
+// ring cannot take the write; the caller then abandons the ring, so a request
+// left in its submission queue is never sent later.
+bool async_frame_writer::submit_write(slot_s& slot) {
+  struct io_uring_sqe* sqe = io_uring_get_sqe(ring.get());
+
+  if(sqe == nullptr) {
+    return false;
+  }
+
+  io_uring_prep_write(sqe,
+                      slot.file,
+                      slot.bytes.data() + slot.written,
+                      (unsigned)(slot.bytes.size() - slot.written),
+                      slot.written);
+  io_uring_sqe_set_data(sqe, &slot);
+
+  if(io_uring_submit(ring.get()) <= 0) {
+    return false;
+  }
+
+  slot.on_ring = true;
+  return true;
+}
+
+// Writes the rest of the slot's bytes on the calling thread. Every write
+// goes to its own offset, so bytes a lost ring request may still write land
+// where these do.
+bool async_frame_writer::write_rest(slot_s& slot) {
+  while(slot.written < slot.bytes.size()) {
+    ssize_t written = pwrite(slot.file,
+                             slot.bytes.data() + slot.written,
+                             slot.bytes.size() - slot.written,
+                             slot.written);
+
+    if(written < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if(written <= 0) {
+      return false;
+    }
+
+    slot.written += written;
+  }
+
+  return true;
+}
+
+void async_frame_writer::complete(slot_s& slot, bool success) {
+  if(slot.file >= 0 && close(slot.file) != 0) {
+    success = false;
+  }
+
+  slot.file = -1;
+  slot.busy = false;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if(!success) {
+      failed_count++;
+    }
+
+    pending--;
+  }
+
+  idle.notify_all();
+}
+
+// Handles the completions that are ready, or with wait set blocks until a
+// write has finished and freed its slot. Short writes are resubmitted for the
+// remainder.
+void async_frame_writer::reap(bool wait) {
+  while(in_flight > 0) {
+    struct io_uring_cqe* cqe    = nullptr;
+    int32_t              result = wait ? io_uring_wait_cqe(ring.get(), &cqe)
+                                       : io_uring_peek_cqe(ring.get(), &cqe);
+
+    if(result == -EINTR || (wait && result == -EAGAIN)) {
+      continue;
+    }
+
+    if(!wait && (result == -EAGAIN || (result == 0 && cqe == nullptr))) {
+      return;
+    }
+
+    if(result != 0 || cqe == nullptr) {
+      abandon_ring();
+      return;
+    }
+
+    slot_s& slot    = *(slot_s*)io_uring_cqe_get_data(cqe);
+    int32_t written = cqe->res;
+
+    io_uring_cqe_seen(ring.get(), cqe);
+    slot.on_ring = false;
+
+    if(written > 0) {
+      slot.written += written;
+    }
+
+    if(written > 0 && slot.written < slot.bytes.size()) {
+      if(!submit_write(slot)) {
+        abandon_ring();
+        return;
+      }
+
+      continue;
+    }
+
+    in_flight--;
+    complete(slot, written > 0);
+    wait = false;
+  }
+}
+
+// Gives up on a ring that fails to take writes or deliver their completions:
+// the frames of every busy slot are finished synchronously and later frames
+// skip the ring. Requests already on the ring still read their slot's bytes
+// and write its file, so their completions are drained before any slot is
+// finished and reused.
+void async_frame_writer::abandon_ring() {
+  ring_ready = false;
+
+  size_t outstanding = 0;
+
+  for(const slot_s& slot : slots) {
+    outstanding += slot.on_ring;
+  }
+
+  while(outstanding > 0) {
+    struct io_uring_cqe* cqe    = nullptr;
+    int32_t              result = io_uring_wait_cqe(ring.get(), &cqe);
+
+    if(result == -EINTR || result == -EAGAIN) {
+      continue;
+    }
+
+    if(result != 0 || cqe == nullptr) {
+      break;
+    }
+
+    ((slot_s*)io_uring_cqe_get_data(cqe))->on_ring = false;
+    io_uring_cqe_seen(ring.get(), cqe);
+    outstanding--;
+  }
+
+  io_uring_queue_exit(ring.get());
+  ring.reset();
+
+  for(slot_s& slot : slots) {
+    if(!slot.busy) {
+      continue;
+    }
+
+    bool success = write_rest(slot);
+
+    // A request the ring never completed may still write these bytes to the
+    // same offsets, so they are kept as they are until the writer goes away.
+    if(slot.on_ring) {
+      retired.push_back(std::move(slot.bytes));
+      slot.bytes   = std::vector<uint8_t>();
+      slot.on_ring = false;
+    }
+
+    complete(slot, success);
+  }
+
+  in_flight = 0;
+}
+
+// Returns a slot that is not busy, waiting for a write to finish while all
+// of them are.
+async_frame_writer::slot_s& async_frame_writer::free_slot() {
+  reap(false);
+
+  while(in_flight == slots.size()) {
+    reap(true);
+  }
+
+  for(slot_s& slot : slots) {
+    if(!slot.busy) {
+      return slot;
+    }
+  }
+
+  // Only slots with a write on the ring stay busy, so this is unreachable;
+  // should the count ever drift, finishing every write synchronously frees
+  // the slots instead of dropping the frame.
+  abandon_ring();
+  return slots.front();
+}
+
+void async_frame_writer::write(frame_s& frame, slot_s& slot) {
+  encode_image(slot.bytes,
+               image_format_for_filename(frame.filename.c_str(), format),
+               frame.image.data(),
+               frame.image.width(),
+               frame.image.height(),
+               frame.image.stride());
+
+  frame.image = framebuffer();
+
+  slot.written = 0;
+  slot.busy    = true;
+  slot.file = open(frame.filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+  if(slot.file < 0 || slot.bytes.empty()) {
+    complete(slot, slot.file >= 0);
+    return;
+  }
+
+  // Kernels without io_uring (or with it disabled) still get their frames,
+  // just written synchronously on the worker thread.
+  if(!ring_ready) {
+    complete(slot, write_rest(slot));
+    return;
+  }
+
+  if(!submit_write(slot)) {
+    abandon_ring();
+    return;
+  }
+
+  in_flight++;
+}
+
+void async_frame_writer::worker() {
+  while(true) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // With writes outstanding the worker sleeps on the ring rather than the
+    // queue; a completion frees a slot and the queue is checked again.
+    while(queue.empty() && !stopping && in_flight > 0) {
+      lock.unlock();
+      reap(true);
+      lock.lock();
+    }
+
+    not_empty.wait(lock, [this] { return !queue.empty() || stopping; });
+
+    if(queue.empty()) {
+      return;
+    }
+
+    frame_s frame = std::move(queue.front());
+    queue.pop_front();
+
+    lock.unlock();
+    not_full.notify_one();
+
+    write(frame, free_slot());
+  }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "framebuffer.h"
+#include "image_writer.h"
+
+// Kept opaque so users of the writer do not need the liburing headers.
+struct io_uring;
+
+// Writes frames in the background so rendering the next frame overlaps
+// encoding and writing the previous one. submit takes ownership of a finished
+// framebuffer and only blocks once queue_depth frames are waiting; a single
+// worker thread encodes them and keeps up to queue_depth writes in flight
+// through io_uring. Framebuffers come from acquire and go back to its pool
+// once their frame has been encoded, so they must not outlive the writer.
+// Each frame is encoded in the format its filename's extension asks for;
+// format only applies to filenames without a known extension.
+class async_frame_writer {
+  public:
+    explicit async_frame_writer(size_t         queue_depth = 4,
+                                image_format_e format      = IMAGE_FORMAT_PPM);
+    ~async_frame_writer();
+
+    async_frame_writer(const async_frame_writer&)            = delete;
+    async_frame_writer& operator=(const async_frame_writer&) = delete;
+
+    // Returns a framebuffer, reusing the storage of an already encoded frame
+    // when possible. Encoding leaves the pixels alone, so reused storage
+    // still holds that frame (see framebuffer_pool::acquire).
+    framebuffer acquire(int32_t width, int32_t height);
+
+    void submit(std::string filename, framebuffer image);
+
+    // Returns once every submitted frame has been written and closed.
+    void flush();
+
+    // Number of frames that could not be opened or written so far.
+    size_t failures() const;
+
+  private:
+    struct frame_s {
+        std::string filename;
+        framebuffer image;
+    };
+
+    struct slot_s {
+        std::vector<uint8_t> bytes;
+        size_t               written = 0;
+        int32_t              file    = -1;
+        bool                 busy    = false;
+        bool                 on_ring = false;
+    };
+
+    void    worker();
+    slot_s& free_slot();
+    void    write(frame_s& frame, slot_s& slot);
+    bool    submit_write(slot_s& slot);
+    bool    write_rest(slot_s& slot);
+    void    complete(slot_s& slot, bool success);
+    void    reap(bool wait);
+    void    abandon_ring();
+
+    image_format_e   format;
+    size_t           queue_depth;
+    framebuffer_pool pool;
+
+    std::unique_ptr<struct io_uring>  ring;
+    bool                              ring_ready = false;
+    std::vector<slot_s>               slots;
+    size_t                            in_flight  = 0;
+    // Bytes of writes an abandoned ring never completed (see abandon_ring).
+    std::vector<std::vector<uint8_t>> retired;
+
+    mutable std::mutex      mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::condition_variable idle;
+    std::deque<frame_s>     queue;
+    size_t                  pending      = 0;
+    size_t                  failed_count = 0;
+    bool                    stopping     = false;
+
+    std::thread thread;
+};
@@ -1,7 +1,16 @@
 #include <math.h>
 
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
 #include "celero/Celero.h"
 
+#include "util.h"
+#include "framebuffer_fill.h"
+#include "procedural_texture.h"
+#include "thread_pool.h"
+
 CELERO_MAIN
 
 float Q_rsqrt(float number) {
@@ -47,3 +56,282 @@ BENCHMARK_F(isqrt, carmack, demo_simple_fixture, 100, 10000000) {
   auto result = Q_rsqrt(test_value);
   celero::DoNotOptimizeAway(result != 0);
 }
+
+// The loops the fill primitives replaced, kept here as baselines.
+static void legacy_clear_framebuffer(uint32_t* image,
+                                     int32_t   image_width,
+                                     int32_t   image_height) {
+  for(int32_t index_y = 0; index_y < image_height; index_y++) {
+    for(int32_t index_x = 0; index_x < image_width; index_x++) {
+      image[index_x + index_y * image_width] = pack_color(0, 0, 0, 255);
+    }
+  }
+}
+
+static void legacy_draw_rectangle(std::vector<uint32_t>& image,
+                                  const size_t           img_w,
+                                  const size_t           img_h,
+                                  const size_t           x,
+                                  const size_t           y,
+                                  const size_t           w,
+                                  const size_t           h,
+                                  const uint32_t         color) {
+  for(size_t j = 0; j < h; j++) {
+    size_t cy = y + j;
+    if(cy >= img_h) {
+      continue;
+    }
+
+    for(size_t i = 0; i < w; i++) {
+      size_t cx = x + i;
+
+      if(cx >= img_w) {
+        continue;
+      }
+
+      image[cx + cy * img_w] = color;
+    }
+  }
+}
+
+// Square surfaces from 256x256 (256 KiB, cache resident) to 4096x4096
+// (64 MiB, well past the non-temporal threshold).
+class surface_fixture : public celero::TestFixture {
+  public:
+    std::vector<celero::TestFixture::ExperimentValue>
+    getExperimentValues() const override {
+      return { 256, 512, 1024, 2048, 4096 };
+    }
+
+    void setUp(const celero::TestFixture::ExperimentValue& value) override {
+      size = (int32_t)value.Value;
+      image.assign((size_t)size * size, 0);
+      source.assign((size_t)size * size, pack_color(1, 2, 3, 255));
+    }
+
+    int32_t               size = 0;
+    std::vector<uint32_t> image;
+    std::vector<uint32_t> source;
+};
+
+BASELINE_F(fill, legacy_clear, surface_fixture, 10, 10) {
+  legacy_clear_framebuffer(image.data(), size, size);
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+BENCHMARK_F(fill, fill_pixels, surface_fixture, 10, 10) {
+  fill_pixels(image.data(), image.size(), pack_color(0, 0, 0, 255));
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+// A rectangle hanging off the bottom right corner, so both versions clip.
+BASELINE_F(fill_rect, legacy_draw_rectangle, surface_fixture, 10, 10) {
+  legacy_draw_rectangle(image,
+                        size,
+                        size,
+                        size / 4,
+                        size / 4,
+                        size,
+                        size,
+                        pack_color(255, 0, 0, 255));
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+BENCHMARK_F(fill_rect, fill_rect, surface_fixture, 10, 10) {
+  fill_rect(image.data(),
+            size,
+            size,
+            size / 4,
+            size / 4,
+            size,
+            size,
+            pack_color(255, 0, 0, 255));
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+// Every column of the surface, drawn the way the raycaster draws walls.
+BASELINE_F(fill_span, legacy_draw_rectangle, surface_fixture, 10, 10) {
+  for(int32_t x = 0; x < size; x++) {
+    legacy_draw_rectangle(image,
+                          size,
+                          size,
+                          x,
+                          size / 4,
+                          1,
+                          size / 2,
+                          pack_color(0, 255, 0, 255));
+  }
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+BENCHMARK_F(fill_span, fill_span, surface_fixture, 10, 10) {
+  for(int32_t x = 0; x < size; x++) {
+    fill_span(image.data(),
+              size,
+              size,
+              x,
+              size / 4,
+              size / 2,
+              pack_color(0, 255, 0, 255));
+  }
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+BASELINE_F(copy, per_pixel, surface_fixture, 10, 10) {
+  for(int32_t y = 0; y < size; y++) {
+    for(int32_t x = 0; x < size; x++) {
+      image[x + y * size] = source[x + y * size];
+    }
+  }
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+BENCHMARK_F(copy, copy_rect, surface_fixture, 10, 10) {
+  copy_rect(image.data(), size, size, 0, 0, source.data(), size, size);
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+// The rock colors of generate_random_pattern.
+static const uint32_t PATTERN_PALETTE[] = {
+  pack_color(103, 103, 95, 255),
+  pack_color(193, 159, 160, 255),
+  pack_color(228, 238, 247, 255),
+};
+
+static constexpr size_t PATTERN_PALETTE_SIZE = 3;
+
+// generate_random_pattern before the counter-based fill: one drand48 call per
+// pixel, walking the row-major surface a column at a time.
+BASELINE_F(random_pattern, drand48, surface_fixture, 10, 10) {
+  for(int32_t x = 0; x < size; x++) {
+    for(int32_t y = 0; y < size; y++) {
+      size_t index = std::min(size_t(drand48() * PATTERN_PALETTE_SIZE),
+                              PATTERN_PALETTE_SIZE - 1);
+
+      image[x + (size_t)y * size] = PATTERN_PALETTE[index];
+    }
+  }
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+BENCHMARK_F(random_pattern, scalar, surface_fixture, 10, 10) {
+  framebuffer_view_t view{ image.data(), size, size, size };
+
+  fill_random_pattern_scalar(view,
+                             PATTERN_PALETTE,
+                             PATTERN_PALETTE_SIZE,
+                             1);
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+BENCHMARK_F(random_pattern, simd, surface_fixture, 10, 10) {
+  framebuffer_view_t view{ image.data(), size, size, size };
+
+  fill_random_pattern(view,
+                      PATTERN_PALETTE,
+                      PATTERN_PALETTE_SIZE,
+                      1);
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+BENCHMARK_F(random_pattern, threads, surface_fixture, 10, 10) {
+  static thread_pool pool;
+  framebuffer_view_t view{ image.data(), size, size, size };
+
+  fill_random_pattern(view,
+                      PATTERN_PALETTE,
+                      PATTERN_PALETTE_SIZE,
+                      1,
+                      &pool);
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+// One 1024x1024 frame worth of pixels, as planar floats and packed.
+class color_fixture : public celero::TestFixture {
+  public:
+    static constexpr size_t COUNT = 1024 * 1024;
+
+    color_fixture()
+      : red(COUNT)
+      , green(COUNT)
+      , blue(COUNT)
+      , alpha(COUNT)
+      , colors(COUNT) {
+      for(size_t index = 0; index < COUNT; index++) {
+        red[index]   = (index % 256) / 255.0f;
+        green[index] = (index % 199) / 198.0f;
+        blue[index]  = (index % 97) / 96.0f;
+        alpha[index] = 1.0f;
+      }
+    }
+
+    std::vector<float>    red;
+    std::vector<float>    green;
+    std::vector<float>    blue;
+    std::vector<float>    alpha;
+    std::vector<uint32_t> colors;
+};
+
+BASELINE_F(pack_colors, pack_color, color_fixture, 10, 10) {
+  for(size_t index = 0; index < COUNT; index++) {
+    colors[index] = pack_color((uint8_t)(red[index] * 255 + 0.5f),
+                               (uint8_t)(green[index] * 255 + 0.5f),
+                               (uint8_t)(blue[index] * 255 + 0.5f),
+                               (uint8_t)(alpha[index] * 255 + 0.5f));
+  }
+  celero::DoNotOptimizeAway(colors[0] == 128);
+}
+
+BENCHMARK_F(pack_colors, scalar, color_fixture, 10, 10) {
+  pack_colors_float_scalar(colors.data(),
+                           red.data(),
+                           green.data(),
+                           blue.data(),
+                           alpha.data(),
+                           COUNT);
+  celero::DoNotOptimizeAway(colors[0] == 128);
+}
+
+BENCHMARK_F(pack_colors, simd, color_fixture, 10, 10) {
+  pack_colors_float(colors.data(),
+                    red.data(),
+                    green.data(),
+                    blue.data(),
+                    alpha.data(),
+                    COUNT);
+  celero::DoNotOptimizeAway(colors[0] == 128);
+}
+
+BASELINE_F(unpack_colors, unpack_color, color_fixture, 10, 10) {
+  for(size_t index = 0; index < COUNT; index++) {
+    uint8_t r, g, b, a;
+
+    unpack_color(colors[index], &r, &g, &b, &a);
+
+    red[index]   = r / 255.0f;
+    green[index] = g / 255.0f;
+    blue[index]  = b / 255.0f;
+    alpha[index] = a / 255.0f;
+  }
+  celero::DoNotOptimizeAway(red[0] == 128);
+}
+
+BENCHMARK_F(unpack_colors, scalar, color_fixture, 10, 10) {
+  unpack_colors_float_scalar(red.data(),
+                             green.data(),
+                             blue.data(),
+                             alpha.data(),
+                             colors.data(),
+                             COUNT);
+  celero::DoNotOptimizeAway(red[0] == 128);
+}
+
+BENCHMARK_F(unpack_colors, simd, color_fixture, 10, 10) {
+  unpack_colors_float(red.data(),
+                      green.data(),
+                      blue.data(),
+                      alpha.data(),
+                      colors.data(),
+                      COUNT);
+  celero::DoNotOptimizeAway(red[0] == 128);
+}
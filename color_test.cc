@@ -0,0 +1,107 @@
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include "util.h"
+
+// Checks the batch color conversions against their scalar references, and
+// that packed pixels survive a trip through the float planes and through
+// interleaved RGBA unchanged. The count leaves a tail after every vector
+// width.
+
+static constexpr size_t COUNT = 4099;
+
+int32_t main() {
+  std::vector<uint32_t> colors(COUNT);
+  std::vector<uint32_t> packed(COUNT);
+  std::vector<uint32_t> reference(COUNT);
+  std::vector<uint8_t>  rgba(COUNT * 4);
+  std::vector<float>    planes[4];
+  std::vector<float>    reference_planes[4];
+
+  for(size_t index = 0; index < COUNT; index++) {
+    colors[index] = (uint32_t)(index * 2654435761u);
+  }
+
+  for(size_t plane = 0; plane < 4; plane++) {
+    planes[plane].resize(COUNT);
+    reference_planes[plane].resize(COUNT);
+  }
+
+  unpack_colors_float(planes[0].data(),
+                      planes[1].data(),
+                      planes[2].data(),
+                      planes[3].data(),
+                      colors.data(),
+                      COUNT);
+  unpack_colors_float_scalar(reference_planes[0].data(),
+                             reference_planes[1].data(),
+                             reference_planes[2].data(),
+                             reference_planes[3].data(),
+                             colors.data(),
+                             COUNT);
+
+  size_t errors = 0;
+
+  for(size_t plane = 0; plane < 4; plane++) {
+    if(planes[plane] != reference_planes[plane]) {
+      std::cerr << "unpack_colors_float: plane " << plane
+                << " differs from scalar" << std::endl;
+      errors++;
+    }
+  }
+
+  // Out of range, NaN and halfway values exercise the clamp and rounding.
+  planes[0][0] = -1.0f;
+  planes[1][1] = 2.0f;
+  planes[2][2] = std::numeric_limits<float>::quiet_NaN();
+  planes[3][3] = 127.5f / 255.0f;
+
+  pack_colors_float(packed.data(),
+                    planes[0].data(),
+                    planes[1].data(),
+                    planes[2].data(),
+                    planes[3].data(),
+                    COUNT);
+  pack_colors_float_scalar(reference.data(),
+                           planes[0].data(),
+                           planes[1].data(),
+                           planes[2].data(),
+                           planes[3].data(),
+                           COUNT);
+
+  if(packed != reference) {
+    std::cerr << "pack_colors_float: differs from scalar" << std::endl;
+    errors++;
+  }
+
+  for(size_t index = 4; index < COUNT; index++) {
+    if(packed[index] != colors[index]) {
+      std::cerr << "float round trip: " << index << " changed" << std::endl;
+      errors++;
+    }
+  }
+
+  unpack_colors(rgba.data(), colors.data(), COUNT);
+  pack_colors(packed.data(), rgba.data(), COUNT);
+
+  for(size_t index = 0; index < COUNT; index++) {
+    uint8_t r, g, b, a;
+
+    unpack_color(colors[index], &r, &g, &b, &a);
+
+    if(packed[index] != colors[index]) {
+      std::cerr << "rgba round trip: " << index << " changed" << std::endl;
+      errors++;
+    }
+
+    if(pack_color(r, g, b, a) != colors[index]) {
+      std::cerr << "unpack_color: " << index << " does not pack back"
+                << std::endl;
+      errors++;
+    }
+  }
+
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,303 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "framebuffer.h"
+#include "image_diff.h"
+#include "sequence_writer.h"
+
+// Golden image gate for the renderers.
+//
+//   compare [--tolerance N] [--tiles SIZE] expected actual
+//     Compares every image of actual against the image at the same position
+//     in expected. Without --tolerance the comparison is exact. --tiles also
+//     lists the SIZE x SIZE tiles whose hashes differ.
+//
+//   compare --checksum file...
+//     Prints one checksum per image, for recording golden values.
+//
+//   compare --verify checksums
+//     Checks the images against a list printed by --checksum, with the file
+//     names taken relative to the current directory. Fails when an image is
+//     missing, extra or has a different checksum.
+//
+// Files ending in .y4m or .drle are read as sequences, anything else as PPM
+// or PAM images. Exits with 0 when everything matches, 1 when something
+// differs and 2 when a file cannot be read.
+
+static constexpr int32_t EXIT_DIFFERENT = 1;
+static constexpr int32_t EXIT_ERROR     = 2;
+
+// Frames of one file, whichever of the two readers it needs.
+class frame_source {
+  public:
+    bool open(const char* filename) {
+      is_sequence = is_sequence_filename(filename);
+
+      return is_sequence ? sequences.open(filename) : images.open(filename);
+    }
+
+    bool read(framebuffer& image) {
+      return is_sequence ? sequences.read(image) : images.read(image);
+    }
+
+    bool failed() const {
+      return is_sequence ? sequences.failed() : images.failed();
+    }
+
+  private:
+    image_reader    images;
+    sequence_reader sequences;
+    bool            is_sequence = false;
+};
+
+static int32_t print_checksums(int32_t argument_count, char** arguments) {
+  framebuffer image;
+
+  for(int32_t index = 0; index < argument_count; index++) {
+    frame_source reader;
+
+    if(!reader.open(arguments[index])) {
+      std::cerr << "Cannot open " << arguments[index] << std::endl;
+      return EXIT_ERROR;
+    }
+
+    for(size_t frame = 0; reader.read(image); frame++) {
+      std::cout << arguments[index] << " " << frame << " " << std::hex
+                << std::setw(16) << std::setfill('0')
+                << image_checksum(image.view()) << std::dec << std::endl;
+    }
+
+    if(reader.failed()) {
+      std::cerr << arguments[index] << " is malformed" << std::endl;
+      return EXIT_ERROR;
+    }
+  }
+
+  return 0;
+}
+
+// One line of the list --checksum prints.
+struct checksum_entry_s {
+    std::string filename;
+    size_t      frame;
+    uint64_t    checksum;
+};
+
+static bool read_checksums(const char*                    filename,
+                           std::vector<checksum_entry_s>& entries) {
+  std::ifstream input(filename);
+
+  if(!input) {
+    return false;
+  }
+
+  checksum_entry_s entry;
+
+  while(input >> entry.filename >> entry.frame >> std::hex >> entry.checksum >>
+        std::dec) {
+    entries.push_back(entry);
+  }
+
+  return input.eof() && !entries.empty();
+}
+
+static int32_t verify_checksums(const char* filename) {
+  std::vector<checksum_entry_s> entries;
+
+  if(!read_checksums(filename, entries)) {
+    std::cerr << "Cannot read checksums from " << filename << std::endl;
+    return EXIT_ERROR;
+  }
+
+  framebuffer image;
+  size_t      matching  = 0;
+  size_t      different = 0;
+
+  // Entries of one file are consecutive and in frame order, as --checksum
+  // prints them.
+  for(size_t first = 0; first < entries.size();) {
+    const std::string& name = entries[first].filename;
+    frame_source       reader;
+
+    if(!reader.open(name.c_str())) {
+      std::cerr << "Cannot open " << name << std::endl;
+      return EXIT_ERROR;
+    }
+
+    size_t index = first;
+
+    for(size_t frame = 0; reader.read(image); frame++, index++) {
+      if(index == entries.size() || entries[index].filename != name ||
+         entries[index].frame != frame) {
+        std::cout << name << ": frame " << frame << " is not expected"
+                  << std::endl;
+        different++;
+        break;
+      }
+
+      if(image_checksum(image.view()) != entries[index].checksum) {
+        std::cout << name << ": frame " << frame << " differs" << std::endl;
+        different++;
+      } else {
+        matching++;
+      }
+    }
+
+    if(reader.failed()) {
+      std::cerr << name << " is malformed" << std::endl;
+      return EXIT_ERROR;
+    }
+
+    for(; index < entries.size() && entries[index].filename == name; index++) {
+      std::cout << name << ": frame " << entries[index].frame << " is missing"
+                << std::endl;
+      different++;
+    }
+
+    first = index;
+  }
+
+  std::cout << matching << " of " << entries.size() << " images match"
+            << std::endl;
+
+  return different == 0 ? 0 : EXIT_DIFFERENT;
+}
+
+static void print_tiles(const framebuffer& expected,
+                        const framebuffer& actual,
+                        int32_t            tile_size) {
+  std::vector<uint64_t> expected_hashes =
+      hash_tiles(expected.view(), tile_size);
+  std::vector<uint64_t> actual_hashes = hash_tiles(actual.view(), tile_size);
+
+  int32_t tiles_x = (expected.width() + tile_size - 1) / tile_size;
+
+  for(size_t index = 0; index < expected_hashes.size(); index++) {
+    if(expected_hashes[index] == actual_hashes[index]) {
+      continue;
+    }
+
+    std::cout << "  tile " << (index % tiles_x) * tile_size << ","
+              << (index / tiles_x) * tile_size << std::endl;
+  }
+}
+
+int32_t main(int32_t argument_count, char** arguments) {
+  int32_t tolerance = -1;
+  int32_t tile_size = 0;
+  int32_t index     = 1;
+
+  if(argument_count > 1 && std::strcmp(arguments[1], "--checksum") == 0) {
+    return print_checksums(argument_count - 2, arguments + 2);
+  }
+
+  if(argument_count == 3 && std::strcmp(arguments[1], "--verify") == 0) {
+    return verify_checksums(arguments[2]);
+  }
+
+  for(; index + 1 < argument_count && arguments[index][0] == '-'; index += 2) {
+    if(std::strcmp(arguments[index], "--tolerance") == 0) {
+      tolerance = std::atoi(arguments[index + 1]);
+    } else if(std::strcmp(arguments[index], "--tiles") == 0) {
+      tile_size = std::atoi(arguments[index + 1]);
+    } else {
+      break;
+    }
+  }
+
+  if(argument_count - index != 2 || tile_size < 0) {
+    std::cerr << "usage: " << arguments[0]
+              << " [--tolerance N] [--tiles SIZE] expected actual\n"
+              << "       " << arguments[0] << " --checksum file...\n"
+              << "       " << arguments[0] << " --verify checksums"
+              << std::endl;
+    return EXIT_ERROR;
+  }
+
+  frame_source expected_reader;
+  frame_source actual_reader;
+
+  if(!expected_reader.open(arguments[index])) {
+    std::cerr << "Cannot open " << arguments[index] << std::endl;
+    return EXIT_ERROR;
+  }
+
+  if(!actual_reader.open(arguments[index + 1])) {
+    std::cerr << "Cannot open " << arguments[index + 1] << std::endl;
+    return EXIT_ERROR;
+  }
+
+  framebuffer expected;
+  framebuffer actual;
+  size_t      frames    = 0;
+  size_t      different = 0;
+
+  while(true) {
+    bool has_expected = expected_reader.read(expected);
+    bool has_actual   = actual_reader.read(actual);
+
+    if(expected_reader.failed() || actual_reader.failed()) {
+      std::cerr << "Malformed image at frame " << frames << std::endl;
+      return EXIT_ERROR;
+    }
+
+    if(!has_expected && !has_actual) {
+      break;
+    }
+
+    if(has_expected != has_actual) {
+      std::cout << "frame count differs: "
+                << (has_expected ? "actual" : "expected") << " ends after "
+                << frames << " frames" << std::endl;
+      return EXIT_DIFFERENT;
+    }
+
+    if(expected.width() != actual.width() ||
+       expected.height() != actual.height()) {
+      std::cout << "frame " << frames << ": size differs, " << expected.width()
+                << "x" << expected.height() << " expected, " << actual.width()
+                << "x" << actual.height() << " actual" << std::endl;
+      different++;
+      frames++;
+      continue;
+    }
+
+    image_difference_s difference{ 0, 0 };
+
+    if(tolerance < 0) {
+      difference.pixels =
+          count_different_pixels(expected.view(), actual.view());
+    } else {
+      difference = compare_images(expected.view(), actual.view(), tolerance);
+    }
+
+    if(difference.pixels != 0) {
+      std::cout << "frame " << frames << ": " << difference.pixels
+                << " pixels differ";
+
+      if(tolerance >= 0) {
+        std::cout << ", largest channel difference " << difference.max_channel;
+      }
+
+      std::cout << std::endl;
+
+      if(tile_size > 0) {
+        print_tiles(expected, actual, tile_size);
+      }
+
+      different++;
+    }
+
+    frames++;
+  }
+
+  std::cout << frames - different << " of " << frames << " frames match"
+            << std::endl;
+
+  return different == 0 ? 0 : EXIT_DIFFERENT;
+}
@@ -0,0 +1,141 @@
+#include "framebuffer.h"
+
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+static constexpr int32_t STRIDE_PIXELS =
+    (int32_t)(framebuffer::ALIGNMENT / sizeof(uint32_t));
+
+static uint32_t* allocate_pixels(size_t capacity) {
+  if(capacity == 0) {
+    return nullptr;
+  }
+
+  void* pixels = std::aligned_alloc(framebuffer::ALIGNMENT,
+                                    capacity * sizeof(uint32_t));
+
+  if(pixels == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  return (uint32_t*)pixels;
+}
+
+int32_t framebuffer::stride_for(int32_t width) {
+  return (width + STRIDE_PIXELS - 1) & ~(STRIDE_PIXELS - 1);
+}
+
+framebuffer::framebuffer(int32_t width, int32_t height)
+  : capacity{ (size_t)stride_for(width) * height }
+  , image_width{ width }
+  , image_height{ height }
+  , image_stride{ stride_for(width) } {
+  pixels = allocate_pixels(capacity);
+}
+
+framebuffer::~framebuffer() {
+  release();
+}
+
+framebuffer::framebuffer(framebuffer&& other) noexcept
+  : pool{ std::exchange(other.pool, nullptr) }
+  , pixels{ std::exchange(other.pixels, nullptr) }
+  , capacity{ std::exchange(other.capacity, 0) }
+  , image_width{ std::exchange(other.image_width, 0) }
+  , image_height{ std::exchange(other.image_height, 0) }
+  , image_stride{ std::exchange(other.image_stride, 0) } {
+}
+
+framebuffer& framebuffer::operator=(framebuffer&& other) noexcept {
+  if(this != &other) {
+    release();
+
+    pool         = std::exchange(other.pool, nullptr);
+    pixels       = std::exchange(other.pixels, nullptr);
+    capacity     = std::exchange(other.capacity, 0);
+    image_width  = std::exchange(other.image_width, 0);
+    image_height = std::exchange(other.image_height, 0);
+    image_stride = std::exchange(other.image_stride, 0);
+  }
+
+  return *this;
+}
+
+void framebuffer::release() {
+  if(pixels == nullptr) {
+    return;
+  }
+
+  if(pool != nullptr) {
+    pool->release(pixels, capacity);
+  } else {
+    std::free(pixels);
+  }
+
+  pool     = nullptr;
+  pixels   = nullptr;
+  capacity = 0;
+}
+
+framebuffer_pool::~framebuffer_pool() {
+  for(const block_s& block : blocks) {
+    std::free(block.pixels);
+  }
+}
+
+framebuffer framebuffer_pool::acquire(int32_t width, int32_t height) {
+  framebuffer result;
+
+  result.image_width  = width;
+  result.image_height = height;
+  result.image_stride = framebuffer::stride_for(width);
+  result.pool         = this;
+
+  size_t needed = (size_t)result.image_stride * height;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Smallest free block that fits, so mixed sizes do not pin big blocks
+    // to small framebuffers.
+    size_t best = blocks.size();
+
+    for(size_t index = 0; index < blocks.size(); index++) {
+      if(blocks[index].capacity >= needed &&
+         (best == blocks.size() ||
+          blocks[index].capacity < blocks[best].capacity)) {
+        best = index;
+      }
+    }
+
+    if(best != blocks.size()) {
+      result.pixels   = blocks[best].pixels;
+      result.capacity = blocks[best].capacity;
+
+      blocks[best] = blocks.back();
+      blocks.pop_back();
+
+      return result;
+    }
+
+    allocation_count++;
+  }
+
+  result.pixels   = allocate_pixels(needed);
+  result.capacity = needed;
+
+  return result;
+}
+
+size_t framebuffer_pool::allocations() const {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  return allocation_count;
+}
+
+void framebuffer_pool::release(uint32_t* pixels, size_t capacity) {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  blocks.push_back(block_s{ pixels, capacity });
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "util.h"
+
+class framebuffer_pool;
+
+// Owns a block of pixels whose rows all start on a 64 byte boundary: the
+// stride is the width rounded up to a multiple of 16 pixels. For widths that
+// already are multiples of 16 the rows are contiguous, so data() can be
+// handed to the functions that take (image, width, height) as is; everything
+// else should go through view().
+class framebuffer {
+  public:
+    static constexpr size_t ALIGNMENT = 64;
+
+    framebuffer() = default;
+    framebuffer(int32_t width, int32_t height);
+    ~framebuffer();
+
+    framebuffer(framebuffer&& other) noexcept;
+    framebuffer& operator=(framebuffer&& other) noexcept;
+
+    framebuffer(const framebuffer&)            = delete;
+    framebuffer& operator=(const framebuffer&) = delete;
+
+    int32_t width() const {
+      return image_width;
+    }
+
+    int32_t height() const {
+      return image_height;
+    }
+
+    // Distance between rows, in pixels and in bytes.
+    int32_t stride() const {
+      return image_stride;
+    }
+
+    size_t pitch() const {
+      return (size_t)image_stride * sizeof(uint32_t);
+    }
+
+    bool contiguous() const {
+      return image_stride == image_width;
+    }
+
+    uint32_t* data() {
+      return pixels;
+    }
+
+    const uint32_t* data() const {
+      return pixels;
+    }
+
+    uint32_t* row(int32_t y) {
+      return pixels + (size_t)y * image_stride;
+    }
+
+    const uint32_t* row(int32_t y) const {
+      return pixels + (size_t)y * image_stride;
+    }
+
+    framebuffer_view_t view() const {
+      return framebuffer_view_t{ pixels,
+                                 image_width,
+                                 image_height,
+                                 image_stride };
+    }
+
+    static int32_t stride_for(int32_t width);
+
+  private:
+    friend class framebuffer_pool;
+
+    void release();
+
+    framebuffer_pool* pool         = nullptr;
+    uint32_t*         pixels       = nullptr;
+    size_t            capacity     = 0;
+    int32_t           image_width  = 0;
+    int32_t           image_height = 0;
+    int32_t           image_stride = 0;
+};
+
+// Keeps the storage of released framebuffers for reuse, so a loop that
+// acquires one framebuffer per frame only allocates until the pool has
+// warmed up. Framebuffers acquired from a pool hand their storage back when
+// they are destroyed, from any thread; the pool must outlive them.
+class framebuffer_pool {
+  public:
+    framebuffer_pool() = default;
+    ~framebuffer_pool();
+
+    framebuffer_pool(const framebuffer_pool&)            = delete;
+    framebuffer_pool& operator=(const framebuffer_pool&) = delete;
+
+    // Reused storage keeps the pixels it was released with, so a caller that
+    // recognizes it by data() and always asks for the same size can update
+    // it incrementally. The contents of new storage are unspecified.
+    framebuffer acquire(int32_t width, int32_t height);
+
+    // Number of blocks allocated by this pool so far.
+    size_t allocations() const;
+
+  private:
+    friend class framebuffer;
+
+    struct block_s {
+        uint32_t* pixels;
+        size_t    capacity;
+    };
+
+    void release(uint32_t* pixels, size_t capacity);
+
+    mutable std::mutex   mutex;
+    std::vector<block_s> blocks;
+    size_t               allocation_count = 0;
+};
@@ -0,0 +1,221 @@
+#include "framebuffer_fill.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__)
+# include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+#endif
+
+static void fill_row(uint32_t* destination,
+                     size_t    count,
+                     uint32_t  color,
+                     bool      streaming) {
+  size_t index = 0;
+
+#if defined(__x86_64__)
+
+  __m128i value = _mm_set1_epi32((int32_t)color);
+
+  if(streaming) {
+    // Streaming stores need 16 byte alignment; pixels are 4 byte aligned, so
+    // at most three of them go out one at a time first.
+    for(; index < count && ((uintptr_t)(destination + index) & 15) != 0;
+        index++) {
+      destination[index] = color;
+    }
+
+    for(; index + 16 <= count; index += 16) {
+      __m128i* output = (__m128i*)(destination + index);
+
+      _mm_stream_si128(output + 0, value);
+      _mm_stream_si128(output + 1, value);
+      _mm_stream_si128(output + 2, value);
+      _mm_stream_si128(output + 3, value);
+    }
+
+    for(; index + 4 <= count; index += 4) {
+      _mm_stream_si128((__m128i*)(destination + index), value);
+    }
+  } else {
+    for(; index + 16 <= count; index += 16) {
+      __m128i* output = (__m128i*)(destination + index);
+
+      _mm_storeu_si128(output + 0, value);
+      _mm_storeu_si128(output + 1, value);
+      _mm_storeu_si128(output + 2, value);
+      _mm_storeu_si128(output + 3, value);
+    }
+
+    for(; index + 4 <= count; index += 4) {
+      _mm_storeu_si128((__m128i*)(destination + index), value);
+    }
+  }
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+
+  // NEON has no non-temporal store intrinsic; streaming is ignored here.
+  uint32x4_t value = vdupq_n_u32(color);
+
+  for(; index + 16 <= count; index += 16) {
+    vst1q_u32(destination + index + 0, value);
+    vst1q_u32(destination + index + 4, value);
+    vst1q_u32(destination + index + 8, value);
+    vst1q_u32(destination + index + 12, value);
+  }
+
+  for(; index + 4 <= count; index += 4) {
+    vst1q_u32(destination + index, value);
+  }
+
+#endif
+
+  for(; index < count; index++) {
+    destination[index] = color;
+  }
+}
+
+static void copy_row(uint32_t*       destination,
+                     const uint32_t* source,
+                     size_t          count,
+                     bool            streaming) {
+#if defined(__x86_64__)
+
+  if(streaming) {
+    size_t index = 0;
+
+    for(; index < count && ((uintptr_t)(destination + index) & 15) != 0;
+        index++) {
+      destination[index] = source[index];
+    }
+
+    for(; index + 4 <= count; index += 4) {
+      __m128i value = _mm_loadu_si128((const __m128i*)(source + index));
+      _mm_stream_si128((__m128i*)(destination + index), value);
+    }
+
+    for(; index < count; index++) {
+      destination[index] = source[index];
+    }
+
+    return;
+  }
+
+#endif
+
+  std::memcpy(destination, source, count * sizeof(uint32_t));
+}
+
+static void finish_streaming(bool streaming) {
+#if defined(__x86_64__)
+  // Streaming stores are weakly ordered; fence them before anyone else
+  // (another thread, or a writer) looks at the pixels.
+  if(streaming) {
+    _mm_sfence();
+  }
+#endif
+}
+
+static bool is_streaming(size_t count) {
+  return count * sizeof(uint32_t) >= NON_TEMPORAL_THRESHOLD;
+}
+
+void fill_pixels(uint32_t* destination, size_t count, uint32_t color) {
+  bool streaming = is_streaming(count);
+
+  fill_row(destination, count, color, streaming);
+  finish_streaming(streaming);
+}
+
+void copy_pixels(uint32_t* destination, const uint32_t* source, size_t count) {
+  bool streaming = is_streaming(count);
+
+  copy_row(destination, source, count, streaming);
+  finish_streaming(streaming);
+}
+
+void fill_rect(uint32_t* image,
+               int32_t   image_width,
+               int32_t   image_height,
+               int32_t   x,
+               int32_t   y,
+               int32_t   width,
+               int32_t   height,
+               uint32_t  color) {
+  int32_t min_x = std::max(x, 0);
+  int32_t min_y = std::max(y, 0);
+  int32_t max_x = (int32_t)std::min<int64_t>((int64_t)x + width, image_width);
+  int32_t max_y = (int32_t)std::min<int64_t>((int64_t)y + height, image_height);
+
+  if(min_x >= max_x || min_y >= max_y) {
+    return;
+  }
+
+  size_t count     = (size_t)(max_x - min_x);
+  bool   streaming = is_streaming(count * (max_y - min_y));
+
+  for(int32_t row = min_y; row < max_y; row++) {
+    fill_row(image + (size_t)row * image_width + min_x,
+             count,
+             color,
+             streaming);
+  }
+
+  finish_streaming(streaming);
+}
+
+void fill_span(uint32_t* image,
+               int32_t   image_width,
+               int32_t   image_height,
+               int32_t   x,
+               int32_t   y,
+               int32_t   height,
+               uint32_t  color) {
+  if(x < 0 || x >= image_width) {
+    return;
+  }
+
+  int32_t min_y = std::max(y, 0);
+  int32_t max_y = (int32_t)std::min<int64_t>((int64_t)y + height, image_height);
+
+  uint32_t* pixel = image + (size_t)min_y * image_width + x;
+
+  for(int32_t row = min_y; row < max_y; row++) {
+    *pixel = color;
+    pixel += image_width;
+  }
+}
+
+void copy_rect(uint32_t*       destination,
+               int32_t         destination_width,
+               int32_t         destination_height,
+               int32_t         x,
+               int32_t         y,
+               const uint32_t* source,
+               int32_t         source_width,
+               int32_t         source_height) {
+  int32_t min_x = std::max(x, 0);
+  int32_t min_y = std::max(y, 0);
+  int32_t max_x = (int32_t)std::min<int64_t>((int64_t)x + source_width,
+                                             destination_width);
+  int32_t max_y = (int32_t)std::min<int64_t>((int64_t)y + source_height,
+                                             destination_height);
+
+  if(min_x >= max_x || min_y >= max_y) {
+    return;
+  }
+
+  size_t count     = (size_t)(max_x - min_x);
+  bool   streaming = is_streaming(count * (max_y - min_y));
+
+  for(int32_t row = min_y; row < max_y; row++) {
+    copy_row(destination + (size_t)row * destination_width + min_x,
+             source + (size_t)(row - y) * source_width + (min_x - x),
+             count,
+             streaming);
+  }
+
+  finish_streaming(streaming);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Operations whose destination is at least this large use non-temporal
+// stores: the surface would evict most of the cache anyway, and streaming
+// skips reading every destination line before overwriting it.
+static constexpr size_t NON_TEMPORAL_THRESHOLD = 4 * 1024 * 1024;
+
+// Sets count pixels to color.
+void fill_pixels(uint32_t* destination, size_t count, uint32_t color);
+
+// Copies count pixels; source and destination must not overlap.
+void copy_pixels(uint32_t* destination, const uint32_t* source, size_t count);
+
+// Fills the rectangle at (x, y), clipped to the image. Negative coordinates
+// and sizes that run past the edges are fine.
+void fill_rect(uint32_t* image,
+               int32_t   image_width,
+               int32_t   image_height,
+               int32_t   x,
+               int32_t   y,
+               int32_t   width,
+               int32_t   height,
+               uint32_t  color);
+
+// Fills the one pixel wide column from (x, y) downwards, clipped to the
+// image. Every pixel touches a different cache line, so this always uses
+// regular stores.
+void fill_span(uint32_t* image,
+               int32_t   image_width,
+               int32_t   image_height,
+               int32_t   x,
+               int32_t   y,
+               int32_t   height,
+               uint32_t  color);
+
+// Copies a whole source image to (x, y) in the destination, clipped to the
+// destination, one row at a time.
+void copy_rect(uint32_t*       destination,
+               int32_t         destination_width,
+               int32_t         destination_height,
+               int32_t         x,
+               int32_t         y,
+               const uint32_t* source,
+               int32_t         source_width,
+               int32_t         source_height);
@@ -0,0 +1,45 @@
+#!/bin/bash
+
+# Golden image test: runs a renderer in an empty directory, then checks what
+# it wrote with compare. Fails through compare's exit code.
+#
+#   golden_test.sh compare renderer [argument...] -- golden...
+#
+# A golden file ending in .txt is a list recorded with compare --checksum
+# and is checked with compare --verify. Any other golden file is an expected
+# image, compared exactly against the output file of the same name.
+
+set -e
+
+COMPARE=$(realpath "$1")
+RENDERER=$(realpath "$2")
+shift 2
+
+ARGUMENTS=()
+
+while [ $# -gt 0 ] && [ "$1" != "--" ]; do
+  ARGUMENTS+=("$1")
+  shift
+done
+
+shift
+
+GOLDEN=()
+
+for FILE in "$@"; do
+  GOLDEN+=("$(realpath "${FILE}")")
+done
+
+OUTPUT=$(mktemp -d "${TEST_TMPDIR:-/tmp}/golden.XXXXXX")
+trap 'rm -rf "${OUTPUT}"' EXIT
+
+cd "${OUTPUT}"
+"${RENDERER}" "${ARGUMENTS[@]}" > /dev/null
+
+for FILE in "${GOLDEN[@]}"; do
+  if [ "${FILE%.txt}" != "${FILE}" ]; then
+    "${COMPARE}" --verify "${FILE}"
+  else
+    "${COMPARE}" --tiles 32 "${FILE}" "$(basename "${FILE}")"
+  fi
+done
@@ -2,17 +2,22 @@
 # include <immintrin.h>
 #endif
 
-#if defined(__ARM_NEON) || defined(__ARM_NEON__)
-# include <arm_neon.h>
-#endif
-
-#if defined(__ARM_FEATURE_SVE)
-# include <arm_sve.h>
-#endif
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
 
 #include "celero/Celero.h"
+#include "celero/UserDefinedMeasurementTemplate.h"
 
+#include "thread_pool.h"
 #include "graphics/rasterizer/triangle.h"
+#include "graphics/rasterizer/depth_buffer.h"
+#include "graphics/rasterizer/texture.h"
+#include "graphics/rasterizer/vertex_layout.h"
 
 CELERO_MAIN
 
@@ -40,18 +45,803 @@ BENCHMARK_F(demo_simple, trinki2_p1, demo_simple_fixture, 100, 100) {
   celero::DoNotOptimizeAway(image[0] == 128);
 }
 
-#if defined(__ARM_NEON)
+BENCHMARK_F(demo_simple, trinki2_p2, demo_simple_fixture, 100, 100) {
+  draw_triangle_trenki2_p2(image, IMAGE_WIDTH, IMAGE_HEIGHT, v0, v1, v2);
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
 
-#endif
+BENCHMARK_F(demo_simple, fixed, demo_simple_fixture, 100, 100) {
+  draw_triangle_fixed(image, IMAGE_WIDTH, IMAGE_HEIGHT, v0, v1, v2);
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
 
-#if defined(__ARM_FEATURE_SVE)
+static point2d_t small_v0{ 264, 264, 1.0f, 0.0f, 0.0f };
+static point2d_t small_v1{ 248, 264, 0.0f, 1.0f, 0.0f };
+static point2d_t small_v2{ 248, 248, 0.0f, 0.0f, 1.0f };
 
-#endif
+BASELINE_F(demo_small, trinki2_p1, demo_simple_fixture, 100, 100) {
+  draw_triangle_trenki2_p1(image,
+                           IMAGE_WIDTH,
+                           IMAGE_HEIGHT,
+                           small_v0,
+                           small_v1,
+                           small_v2);
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
 
-#if defined(__AVX2__)
+BENCHMARK_F(demo_small, joshbeam, demo_simple_fixture, 100, 100) {
+  draw_triangle_joshbeam(image,
+                         IMAGE_WIDTH,
+                         IMAGE_HEIGHT,
+                         small_v0,
+                         small_v1,
+                         small_v2);
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
 
-#endif
+BENCHMARK_F(demo_small, trinki2_p2, demo_simple_fixture, 100, 100) {
+  draw_triangle_trenki2_p2(image,
+                           IMAGE_WIDTH,
+                           IMAGE_HEIGHT,
+                           small_v0,
+                           small_v1,
+                           small_v2);
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+BENCHMARK_F(demo_small, fixed, demo_simple_fixture, 100, 100) {
+  draw_triangle_fixed(image,
+                      IMAGE_WIDTH,
+                      IMAGE_HEIGHT,
+                      small_v0,
+                      small_v1,
+                      small_v2);
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
 
-#if defined(__AVX512F__)
+static constexpr int32_t LARGE_WIDTH  = 2048;
+static constexpr int32_t LARGE_HEIGHT = 2048;
+
+static uint32_t large_image[LARGE_WIDTH * LARGE_HEIGHT] = { 0 };
+
+static point2d_t large_v0{ LARGE_WIDTH, LARGE_HEIGHT, 1.0f, 0.0f, 0.0f };
+static point2d_t large_v1{ 0, LARGE_HEIGHT, 0.0f, 1.0f, 0.0f };
+static point2d_t large_v2{ 0, 0, 0.0f, 0.0f, 1.0f };
+
+BASELINE_F(demo_large, trinki2_p1, demo_simple_fixture, 10, 10) {
+  draw_triangle_trenki2_p1(large_image,
+                           LARGE_WIDTH,
+                           LARGE_HEIGHT,
+                           large_v0,
+                           large_v1,
+                           large_v2);
+  celero::DoNotOptimizeAway(large_image[0] == 128);
+}
+
+BENCHMARK_F(demo_large, joshbeam, demo_simple_fixture, 10, 10) {
+  draw_triangle_joshbeam(large_image,
+                         LARGE_WIDTH,
+                         LARGE_HEIGHT,
+                         large_v0,
+                         large_v1,
+                         large_v2);
+  celero::DoNotOptimizeAway(large_image[0] == 128);
+}
+
+BENCHMARK_F(demo_large, trinki2_p2, demo_simple_fixture, 10, 10) {
+  draw_triangle_trenki2_p2(large_image,
+                           LARGE_WIDTH,
+                           LARGE_HEIGHT,
+                           large_v0,
+                           large_v1,
+                           large_v2);
+  celero::DoNotOptimizeAway(large_image[0] == 128);
+}
+
+BENCHMARK_F(demo_simple, simd, demo_simple_fixture, 100, 100) {
+  draw_triangle_simd(image, IMAGE_WIDTH, IMAGE_HEIGHT, v0, v1, v2);
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+#if defined(__x86_64__)
+
+// The kernels carry their own target attributes, so they are built whatever
+// the compiler flags; on a CPU without the extension the run is left empty.
+BENCHMARK_F(demo_simple, avx2, demo_simple_fixture, 100, 100) {
+  if(!__builtin_cpu_supports("avx2")) {
+    return;
+  }
+
+  draw_triangle_avx2(image, IMAGE_WIDTH, IMAGE_HEIGHT, v0, v1, v2);
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+BENCHMARK_F(demo_simple, avx512, demo_simple_fixture, 100, 100) {
+  if(!__builtin_cpu_supports("avx512f")) {
+    return;
+  }
+
+  draw_triangle_avx512(image, IMAGE_WIDTH, IMAGE_HEIGHT, v0, v1, v2);
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
 
 #endif
+
+static constexpr int32_t BATCH_WIDTH    = 1024;
+static constexpr int32_t BATCH_HEIGHT   = 1024;
+static constexpr size_t  BATCH_COUNT    = 20000;
+static constexpr float   BATCH_MAX_SIZE = 32.0f;
+
+static uint32_t batch_image[BATCH_WIDTH * BATCH_HEIGHT] = { 0 };
+
+class triangles_per_second_udm
+  : public celero::UserDefinedMeasurementTemplate<double> {
+  public:
+    std::string getName() const override {
+      return "triangles/s";
+    }
+};
+
+class pixels_per_second_udm
+  : public celero::UserDefinedMeasurementTemplate<double> {
+  public:
+    std::string getName() const override {
+      return "pixels/s";
+    }
+};
+
+class batch_fixture : public celero::TestFixture {
+  public:
+    batch_fixture()
+      : triangles_per_second{ new triangles_per_second_udm() } {
+      std::mt19937                          random{ 1234 };
+      std::uniform_real_distribution<float> position{ 0.0f, BATCH_WIDTH };
+      std::uniform_real_distribution<float> offset{ 0.0f, BATCH_MAX_SIZE };
+      std::uniform_real_distribution<float> color{ 0.0f, 1.0f };
+
+      for(size_t index = 0; index < BATCH_COUNT; index++) {
+        float x = position(random);
+        float y = position(random);
+
+        point2d_t v0{ x, y, color(random), color(random), color(random) };
+        point2d_t v1{ x + offset(random),
+                      y + offset(random),
+                      color(random),
+                      color(random),
+                      color(random) };
+        point2d_t v2{ x + offset(random),
+                      y + offset(random),
+                      color(random),
+                      color(random),
+                      color(random) };
+
+        float cross = (v1.x - v0.x) * (v2.y - v0.y) -
+                      (v1.y - v0.y) * (v2.x - v0.x);
+
+        if(cross < 0.0f) {
+          std::swap(v1, v2);
+        }
+
+        vertices.push_back(v0);
+        vertices.push_back(v1);
+        vertices.push_back(v2);
+      }
+    }
+
+    std::vector<celero::TestFixture::ExperimentValue>
+    getExperimentValues() const override {
+      std::vector<celero::TestFixture::ExperimentValue> result;
+
+      size_t threads = thread_pool::default_thread_count();
+
+      for(int64_t count : { 1, 2, 4 }) {
+        if(count < (int64_t)threads) {
+          result.push_back(count);
+        }
+      }
+
+      result.push_back(static_cast<int64_t>(threads));
+
+      return result;
+    }
+
+    void setUp(const celero::TestFixture::ExperimentValue& value) override {
+      if(!pool || pool->size() != (size_t)value.Value) {
+        pool = std::make_unique<thread_pool>(value.Value);
+      }
+    }
+
+    std::vector<std::shared_ptr<celero::UserDefinedMeasurement>>
+    getUserDefinedMeasurements() const override {
+      return { triangles_per_second };
+    }
+
+    template <typename Function>
+    void measure(Function function) {
+      auto start = std::chrono::steady_clock::now();
+      function();
+      auto end = std::chrono::steady_clock::now();
+
+      std::chrono::duration<double> seconds = end - start;
+      triangles_per_second->addValue(BATCH_COUNT / seconds.count());
+    }
+
+    std::vector<point2d_t>                    vertices;
+    std::unique_ptr<thread_pool>              pool;
+    std::shared_ptr<triangles_per_second_udm> triangles_per_second;
+};
+
+BASELINE_F(batch, trinki2_p2, batch_fixture, 10, 10) {
+  measure([this] {
+    for(size_t index = 0; index < BATCH_COUNT; index++) {
+      draw_triangle_trenki2_p2(batch_image,
+                               BATCH_WIDTH,
+                               BATCH_HEIGHT,
+                               vertices[index * 3 + 0],
+                               vertices[index * 3 + 1],
+                               vertices[index * 3 + 2]);
+    }
+  });
+  celero::DoNotOptimizeAway(batch_image[0] == 128);
+}
+
+BENCHMARK_F(batch, draw_triangles, batch_fixture, 10, 10) {
+  measure([this] {
+    draw_triangles(*pool,
+                   batch_image,
+                   BATCH_WIDTH,
+                   BATCH_HEIGHT,
+                   vertices.data(),
+                   BATCH_COUNT);
+  });
+  celero::DoNotOptimizeAway(batch_image[0] == 128);
+}
+
+static constexpr int32_t OVERDRAW_LAYERS = 16;
+
+// Full-screen quads stacked in depth. Front to back lets hierarchical z reject
+// every layer after the first per tile, back to front is the worst case.
+class overdraw_fixture : public celero::TestFixture {
+  public:
+    overdraw_fixture()
+      : depth{ IMAGE_WIDTH, IMAGE_HEIGHT, DEPTH_FORMAT_UNORM16 } {
+      for(int32_t layer = 0; layer < OVERDRAW_LAYERS; layer++) {
+        float z = (layer + 1.0f) / (OVERDRAW_LAYERS + 1.0f);
+        float c = (float)layer / OVERDRAW_LAYERS;
+
+        vertex_t top_left{ 0, 0, z, 1.0f, c, 0.0f, 1.0f - c };
+        vertex_t top_right{ IMAGE_WIDTH, 0, z, 1.0f, c, 1.0f, 0.0f };
+        vertex_t bottom_left{ 0, IMAGE_HEIGHT, z, 1.0f, 0.0f, c, 1.0f };
+        vertex_t bottom_right{ IMAGE_WIDTH, IMAGE_HEIGHT, z, 1.0f, 1.0f, c, c };
+
+        for(const vertex_t& v : { top_left,
+                                  top_right,
+                                  bottom_right,
+                                  bottom_right,
+                                  bottom_left,
+                                  top_left }) {
+          layers.push_back(v);
+          flat_layers.push_back(point2d_t{ v.x, v.y, v.r, v.g, v.b });
+        }
+      }
+    }
+
+    void draw_layer(int32_t layer) {
+      const vertex_t* v = &layers[layer * 6];
+
+      draw_triangle_depth(image, depth, v[0], v[1], v[2]);
+      draw_triangle_depth(image, depth, v[3], v[4], v[5]);
+    }
+
+    std::vector<vertex_t>  layers;
+    std::vector<point2d_t> flat_layers;
+    depth_buffer_t         depth;
+};
+
+BASELINE_F(overdraw, painters, overdraw_fixture, 10, 10) {
+  for(int32_t index = (int32_t)flat_layers.size() - 3; index >= 0; index -= 3) {
+    draw_triangle_trenki2_p2(image,
+                             IMAGE_WIDTH,
+                             IMAGE_HEIGHT,
+                             flat_layers[index + 0],
+                             flat_layers[index + 1],
+                             flat_layers[index + 2]);
+  }
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+BENCHMARK_F(overdraw, depth_back_to_front, overdraw_fixture, 10, 10) {
+  depth.clear();
+  for(int32_t layer = OVERDRAW_LAYERS - 1; layer >= 0; layer--) {
+    draw_layer(layer);
+  }
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+BENCHMARK_F(overdraw, depth_front_to_back, overdraw_fixture, 10, 10) {
+  depth.clear();
+  for(int32_t layer = 0; layer < OVERDRAW_LAYERS; layer++) {
+    draw_layer(layer);
+  }
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+// Color, texture coordinate, normal and four extra channels: 12 components.
+using wide_layout_t = vertex_layout_t<3, 2, 3, 4>;
+
+struct wide_shader_s {
+    uint32_t operator()(const wide_layout_t::components_t& components) const {
+      const float* color  = wide_layout_t::get<0>(components);
+      const float* uv     = wide_layout_t::get<1>(components);
+      const float* normal = wide_layout_t::get<2>(components);
+      const float* extra  = wide_layout_t::get<3>(components);
+
+      float light = normal[0] * extra[0] + normal[1] * extra[1] +
+                    normal[2] * extra[2];
+      float fade  = uv[0] * uv[1] * extra[3];
+
+      return pack_color((int32_t)(color[0] * light * 255),
+                        (int32_t)(color[1] * light * 255),
+                        (int32_t)(color[2] * fade * 255),
+                        255);
+    }
+};
+
+static rgb_layout_t::vertex_t rgb_v0{ v0.x, v0.y, { v0.r, v0.g, v0.b } };
+static rgb_layout_t::vertex_t rgb_v1{ v1.x, v1.y, { v1.r, v1.g, v1.b } };
+static rgb_layout_t::vertex_t rgb_v2{ v2.x, v2.y, { v2.r, v2.g, v2.b } };
+
+static wide_layout_t::vertex_t wide_v0{
+  v0.x, v0.y, { 1, 0, 0, 0, 0, 0, 0, 1, 0.2f, 0.3f, 0.9f, 1 }
+};
+static wide_layout_t::vertex_t wide_v1{
+  v1.x, v1.y, { 0, 1, 0, 1, 0, 0, 1, 0, 0.4f, 0.1f, 0.8f, 1 }
+};
+static wide_layout_t::vertex_t wide_v2{
+  v2.x, v2.y, { 0, 0, 1, 0, 1, 1, 0, 0, 0.6f, 0.5f, 0.7f, 1 }
+};
+
+BASELINE_F(layout, trinki2_p2, demo_simple_fixture, 100, 100) {
+  draw_triangle_trenki2_p2(image, IMAGE_WIDTH, IMAGE_HEIGHT, v0, v1, v2);
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+BENCHMARK_F(layout, rgb, demo_simple_fixture, 100, 100) {
+  draw_triangle_layout<rgb_layout_t>(image,
+                                     IMAGE_WIDTH,
+                                     IMAGE_HEIGHT,
+                                     rgb_v0,
+                                     rgb_v1,
+                                     rgb_v2,
+                                     rgb_shader_s{});
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+BENCHMARK_F(layout, wide_12, demo_simple_fixture, 100, 100) {
+  draw_triangle_layout<wide_layout_t>(image,
+                                      IMAGE_WIDTH,
+                                      IMAGE_HEIGHT,
+                                      wide_v0,
+                                      wide_v1,
+                                      wide_v2,
+                                      wide_shader_s{});
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+static constexpr int32_t TEXTURE_SIZE = 1024;
+
+static std::vector<uint32_t> make_noise_texture() {
+  std::mt19937                            random{ 1234 };
+  std::uniform_int_distribution<uint32_t> channel{ 0, 255 };
+  std::vector<uint32_t>                   pixels(TEXTURE_SIZE * TEXTURE_SIZE);
+
+  for(uint32_t& pixel : pixels) {
+    pixel = pack_color(channel(random), channel(random), channel(random), 255);
+  }
+
+  return pixels;
+}
+
+// A quad mapped one texel per pixel (mip level 0), rotated by the experiment
+// value in degrees. At 0 degrees the linear layout walks texture rows in
+// order; at 90 degrees every pixel steps a full row through it.
+class texture_fixture : public celero::TestFixture {
+  public:
+    texture_fixture()
+      : pixels{ make_noise_texture() }
+      , linear{ pixels.data(),
+                TEXTURE_SIZE,
+                TEXTURE_SIZE,
+                TEXTURE_LAYOUT_LINEAR }
+      , morton{ pixels.data(),
+                TEXTURE_SIZE,
+                TEXTURE_SIZE,
+                TEXTURE_LAYOUT_MORTON } {
+    }
+
+    std::vector<celero::TestFixture::ExperimentValue>
+    getExperimentValues() const override {
+      return { 0, 30, 45, 90 };
+    }
+
+    void setUp(const celero::TestFixture::ExperimentValue& value) override {
+      float angle  = value.Value * 3.14159265f / 180.0f;
+      float half   = IMAGE_WIDTH * 0.35f;
+      float extent = 2.0f * half / TEXTURE_SIZE;
+      float sine   = std::sin(angle);
+      float cosine = std::cos(angle);
+
+      float corners[4][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+
+      for(int32_t index = 0; index < 4; index++) {
+        float x = corners[index][0] * half;
+        float y = corners[index][1] * half;
+
+        quad[index] = uv_layout_t::vertex_t{
+          IMAGE_WIDTH / 2 + x * cosine - y * sine,
+          IMAGE_HEIGHT / 2 + x * sine + y * cosine,
+          { (corners[index][0] + 1) * 0.5f * extent,
+            (corners[index][1] + 1) * 0.5f * extent }
+        };
+      }
+    }
+
+    void draw(const texture_t& texture, texture_filter_e filter) {
+      draw_triangle_textured(image,
+                             IMAGE_WIDTH,
+                             IMAGE_HEIGHT,
+                             quad[0],
+                             quad[1],
+                             quad[2],
+                             texture,
+                             filter);
+      draw_triangle_textured(image,
+                             IMAGE_WIDTH,
+                             IMAGE_HEIGHT,
+                             quad[2],
+                             quad[3],
+                             quad[0],
+                             texture,
+                             filter);
+    }
+
+    std::vector<uint32_t> pixels;
+    texture_t             linear;
+    texture_t             morton;
+    uv_layout_t::vertex_t quad[4];
+};
+
+BASELINE_F(texture, linear_nearest, texture_fixture, 30, 30) {
+  draw(linear, TEXTURE_FILTER_NEAREST);
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+BENCHMARK_F(texture, morton_nearest, texture_fixture, 30, 30) {
+  draw(morton, TEXTURE_FILTER_NEAREST);
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+BENCHMARK_F(texture, linear_bilinear, texture_fixture, 30, 30) {
+  draw(linear, TEXTURE_FILTER_BILINEAR);
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+BENCHMARK_F(texture, morton_bilinear, texture_fixture, 30, 30) {
+  draw(morton, TEXTURE_FILTER_BILINEAR);
+  celero::DoNotOptimizeAway(image[0] == 128);
+}
+
+// Area of the part of a triangle that lies inside the image, used to turn
+// timings into pixels per second. Clips against each image edge in turn.
+static double visible_area(const point2d_t& v0,
+                           const point2d_t& v1,
+                           const point2d_t& v2,
+                           float            width,
+                           float            height) {
+  std::vector<std::array<double, 2>> polygon = { { v0.x, v0.y },
+                                                 { v1.x, v1.y },
+                                                 { v2.x, v2.y } };
+
+  for(int32_t plane = 0; plane < 4; plane++) {
+    int32_t axis  = plane & 1;
+    double  limit = plane < 2 ? 0.0 : (axis == 0 ? width : height);
+    double  sign  = plane < 2 ? 1.0 : -1.0;
+
+    std::vector<std::array<double, 2>> clipped;
+
+    for(size_t index = 0; index < polygon.size(); index++) {
+      const std::array<double, 2>& a = polygon[index];
+      const std::array<double, 2>& b = polygon[(index + 1) % polygon.size()];
+
+      double distance_a = sign * (a[axis] - limit);
+      double distance_b = sign * (b[axis] - limit);
+
+      if(distance_a >= 0.0) {
+        clipped.push_back(a);
+      }
+
+      if((distance_a >= 0.0) != (distance_b >= 0.0)) {
+        double t = distance_a / (distance_a - distance_b);
+
+        clipped.push_back({ a[0] + (b[0] - a[0]) * t,
+                            a[1] + (b[1] - a[1]) * t });
+      }
+    }
+
+    polygon = std::move(clipped);
+  }
+
+  double area = 0.0;
+
+  for(size_t index = 0; index < polygon.size(); index++) {
+    const std::array<double, 2>& a = polygon[index];
+    const std::array<double, 2>& b = polygon[(index + 1) % polygon.size()];
+
+    area += a[0] * b[1] - b[0] * a[1];
+  }
+
+  return std::abs(area) * 0.5;
+}
+
+// Randomly placed and rotated right triangles. size is the square root of
+// twice the area, aspect the ratio between the two legs, so slivers keep the
+// pixel count of the square case. Subclasses pick which parameter the
+// experiment value sweeps; everything else stays at the defaults below.
+class scene_fixture : public celero::TestFixture {
+  public:
+    using draw_triangle_t = void (*)(uint32_t*        image,
+                                     int32_t          image_width,
+                                     int32_t          image_height,
+                                     const point2d_t& v0,
+                                     const point2d_t& v1,
+                                     const point2d_t& v2);
+
+  public:
+
+    scene_fixture()
+      : triangles_per_second{ new triangles_per_second_udm() }
+      , pixels_per_second{ new pixels_per_second_udm() } {
+    }
+
+    std::vector<std::shared_ptr<celero::UserDefinedMeasurement>>
+    getUserDefinedMeasurements() const override {
+      return { triangles_per_second, pixels_per_second };
+    }
+
+    void generate(int32_t width,
+                  int32_t height,
+                  size_t  count,
+                  float   size,
+                  float   aspect) {
+      std::mt19937                          random{ 1234 };
+      std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+
+      scene_width  = width;
+      scene_height = height;
+
+      image.assign((size_t)width * height, 0);
+      vertices.clear();
+      vertices.reserve(count * 3);
+      pixels = 0.0;
+
+      float leg_x = size * std::sqrt(aspect);
+      float leg_y = size / std::sqrt(aspect);
+
+      for(size_t index = 0; index < count; index++) {
+        float angle  = unit(random) * 6.2831853f;
+        float sine   = std::sin(angle);
+        float cosine = std::cos(angle);
+        float x      = unit(random) * width;
+        float y      = unit(random) * height;
+
+        point2d_t v0{ x, y, unit(random), unit(random), unit(random) };
+        point2d_t v1{ x + leg_x * cosine,
+                      y + leg_x * sine,
+                      unit(random),
+                      unit(random),
+                      unit(random) };
+        point2d_t v2{ x - leg_y * sine,
+                      y + leg_y * cosine,
+                      unit(random),
+                      unit(random),
+                      unit(random) };
+
+        vertices.push_back(v0);
+        vertices.push_back(v1);
+        vertices.push_back(v2);
+
+        pixels += visible_area(v0, v1, v2, width, height);
+      }
+    }
+
+    template <typename Function>
+    void measure(Function function) {
+      auto start = std::chrono::steady_clock::now();
+      function();
+      auto end = std::chrono::steady_clock::now();
+
+      std::chrono::duration<double> seconds = end - start;
+      triangles_per_second->addValue(vertices.size() / 3 / seconds.count());
+      pixels_per_second->addValue(pixels / seconds.count());
+    }
+
+    void draw_each(draw_triangle_t draw_triangle) {
+      measure([&] {
+        for(size_t index = 0; index < vertices.size(); index += 3) {
+          draw_triangle(image.data(),
+                        scene_width,
+                        scene_height,
+                        vertices[index + 0],
+                        vertices[index + 1],
+                        vertices[index + 2]);
+        }
+      });
+      celero::DoNotOptimizeAway(image[0] == 128);
+    }
+
+    void draw_batched() {
+      measure([&] {
+        draw_triangles(image.data(),
+                       scene_width,
+                       scene_height,
+                       vertices.data(),
+                       vertices.size() / 3);
+      });
+      celero::DoNotOptimizeAway(image[0] == 128);
+    }
+
+    static constexpr int32_t SCENE_WIDTH  = 1024;
+    static constexpr int32_t SCENE_HEIGHT = 1024;
+    static constexpr size_t  SCENE_COUNT  = 10000;
+    static constexpr float   SCENE_SIZE   = 8.0f;
+
+    int32_t                                   scene_width  = 0;
+    int32_t                                   scene_height = 0;
+    std::vector<uint32_t>                     image;
+    std::vector<point2d_t>                    vertices;
+    double                                    pixels = 0.0;
+    std::shared_ptr<triangles_per_second_udm> triangles_per_second;
+    std::shared_ptr<pixels_per_second_udm>    pixels_per_second;
+};
+
+// Edge length in pixels, from single-pixel triangles to ones larger than the
+// screen. The count shrinks with the area so every run shades about the same
+// number of pixels, up to the cap of one million triangles.
+class scene_size_fixture : public scene_fixture {
+  public:
+    std::vector<celero::TestFixture::ExperimentValue>
+    getExperimentValues() const override {
+      return { 1, 2, 4, 8, 16, 64, 256, 1024 };
+    }
+
+    void setUp(const celero::TestFixture::ExperimentValue& value) override {
+      float  size  = (float)value.Value;
+      size_t count =
+          (size_t)(8.0f * SCENE_WIDTH * SCENE_HEIGHT / (size * size));
+
+      generate(SCENE_WIDTH,
+               SCENE_HEIGHT,
+               std::clamp<size_t>(count, 1, 1000000),
+               size,
+               1.0f);
+    }
+};
+
+class scene_count_fixture : public scene_fixture {
+  public:
+    std::vector<celero::TestFixture::ExperimentValue>
+    getExperimentValues() const override {
+      return { 1, 100, 10000, 1000000 };
+    }
+
+    void setUp(const celero::TestFixture::ExperimentValue& value) override {
+      generate(SCENE_WIDTH, SCENE_HEIGHT, value.Value, SCENE_SIZE, 1.0f);
+    }
+};
+
+// Ratio between the legs at a constant area; 256 turns the default triangle
+// into a 128x0.5 pixel sliver.
+class scene_aspect_fixture : public scene_fixture {
+  public:
+    std::vector<celero::TestFixture::ExperimentValue>
+    getExperimentValues() const override {
+      return { 1, 4, 16, 64, 256 };
+    }
+
+    void setUp(const celero::TestFixture::ExperimentValue& value) override {
+      generate(SCENE_WIDTH,
+               SCENE_HEIGHT,
+               SCENE_COUNT,
+               SCENE_SIZE,
+               (float)value.Value);
+    }
+};
+
+// Image width in pixels, 16:9, up to 4K. Triangles scale with the image so
+// the scene looks the same at every resolution.
+class scene_resolution_fixture : public scene_fixture {
+  public:
+    std::vector<celero::TestFixture::ExperimentValue>
+    getExperimentValues() const override {
+      return { 512, 1280, 1920, 2560, 3840 };
+    }
+
+    void setUp(const celero::TestFixture::ExperimentValue& value) override {
+      int32_t width  = (int32_t)value.Value;
+      int32_t height = width * 9 / 16;
+
+      generate(width,
+               height,
+               SCENE_COUNT,
+               SCENE_SIZE * width / SCENE_WIDTH,
+               1.0f);
+    }
+};
+
+BASELINE_F(scene_size, trinki2_p2, scene_size_fixture, 5, 1) {
+  draw_each(draw_triangle_trenki2_p2);
+}
+
+BENCHMARK_F(scene_size, fixed, scene_size_fixture, 5, 1) {
+  draw_each(draw_triangle_fixed);
+}
+
+BENCHMARK_F(scene_size, simd, scene_size_fixture, 5, 1) {
+  draw_each(draw_triangle_simd);
+}
+
+BENCHMARK_F(scene_size, draw_triangles, scene_size_fixture, 5, 1) {
+  draw_batched();
+}
+
+BASELINE_F(scene_count, trinki2_p2, scene_count_fixture, 5, 1) {
+  draw_each(draw_triangle_trenki2_p2);
+}
+
+BENCHMARK_F(scene_count, fixed, scene_count_fixture, 5, 1) {
+  draw_each(draw_triangle_fixed);
+}
+
+BENCHMARK_F(scene_count, simd, scene_count_fixture, 5, 1) {
+  draw_each(draw_triangle_simd);
+}
+
+BENCHMARK_F(scene_count, draw_triangles, scene_count_fixture, 5, 1) {
+  draw_batched();
+}
+
+BASELINE_F(scene_aspect, trinki2_p2, scene_aspect_fixture, 5, 1) {
+  draw_each(draw_triangle_trenki2_p2);
+}
+
+BENCHMARK_F(scene_aspect, fixed, scene_aspect_fixture, 5, 1) {
+  draw_each(draw_triangle_fixed);
+}
+
+BENCHMARK_F(scene_aspect, simd, scene_aspect_fixture, 5, 1) {
+  draw_each(draw_triangle_simd);
+}
+
+BENCHMARK_F(scene_aspect, draw_triangles, scene_aspect_fixture, 5, 1) {
+  draw_batched();
+}
+
+BASELINE_F(scene_resolution, trinki2_p2, scene_resolution_fixture, 5, 1) {
+  draw_each(draw_triangle_trenki2_p2);
+}
+
+BENCHMARK_F(scene_resolution, fixed, scene_resolution_fixture, 5, 1) {
+  draw_each(draw_triangle_fixed);
+}
+
+BENCHMARK_F(scene_resolution, simd, scene_resolution_fixture, 5, 1) {
+  draw_each(draw_triangle_simd);
+}
+
+BENCHMARK_F(scene_resolution,
+            draw_triangles,
+            scene_resolution_fixture,
+            5,
+            1) {
+  draw_batched();
+}
@@ -0,0 +1,28 @@
+#include <algorithm>
+
+#include "graphics/rasterizer/depth_buffer.h"
+
+depth_buffer_t::depth_buffer_t(int32_t        width,
+                               int32_t        height,
+                               depth_format_e format)
+  : width{ width }
+  , height{ height }
+  , tiles_x{ (width + TILE_SIZE - 1) / TILE_SIZE }
+  , tiles_y{ (height + TILE_SIZE - 1) / TILE_SIZE }
+  , format{ format } {
+  if(format == DEPTH_FORMAT_UNORM16) {
+    unorm16.resize(width * height);
+  } else {
+    float32.resize(width * height);
+  }
+
+  tile_max.resize(tiles_x * tiles_y);
+
+  clear();
+}
+
+void depth_buffer_t::clear() {
+  std::fill(unorm16.begin(), unorm16.end(), UINT16_MAX);
+  std::fill(float32.begin(), float32.end(), 1.0f);
+  std::fill(tile_max.begin(), tile_max.end(), 1.0f);
+}
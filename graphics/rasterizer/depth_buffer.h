@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+enum depth_format_e {
+  DEPTH_FORMAT_UNORM16,
+  DEPTH_FORMAT_FLOAT32,
+};
+
+// Depth in [0, 1], smaller is closer. Next to the per-pixel values it keeps
+// the farthest depth stored in every 8x8 tile, which lets the rasterizer
+// reject a whole tile before shading when a triangle is behind everything
+// already drawn there.
+struct depth_buffer_t {
+    static constexpr int32_t TILE_SIZE = 8;
+
+    int32_t        width;
+    int32_t        height;
+    int32_t        tiles_x;
+    int32_t        tiles_y;
+    depth_format_e format;
+
+    std::vector<uint16_t> unorm16;
+    std::vector<float>    float32;
+    std::vector<float>    tile_max;
+
+    depth_buffer_t(int32_t width, int32_t height, depth_format_e format);
+
+    void clear();
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "graphics/rasterizer/triangle.h"
+
+struct edge_equation_s {
+    float a;
+    float b;
+    float c;
+    bool  tie;
+
+    template <typename vertex_type>
+    edge_equation_s(const vertex_type& v0, const vertex_type& v1) {
+      a   = v0.y - v1.y;
+      b   = v1.x - v0.x;
+      c   = -(a * (v0.x + v1.x) + b * (v0.y + v1.y)) / 2;
+      tie = a != 0 ? a > 0 : b > 0;
+    }
+
+    float evaluate(float x, float y) const {
+      return a * x + b * y + c;
+    }
+
+    bool test(float x, float y) const {
+      return test(evaluate(x, y));
+    }
+
+    bool test(float v) const {
+      return (v > 0 || (v == 0 && tie));
+    }
+};
+
+struct parameter_equation_s {
+    float a;
+    float b;
+    float c;
+
+    parameter_equation_s(float                  p0,
+                         float                  p1,
+                         float                  p2,
+                         const edge_equation_s& e0,
+                         const edge_equation_s& e1,
+                         const edge_equation_s& e2,
+                         float                  area) {
+      float factor = 1.0f / (2.0f * area);
+
+      a = factor * (p0 * e0.a + p1 * e1.a + p2 * e2.a);
+      b = factor * (p0 * e0.b + p1 * e1.b + p2 * e2.b);
+      c = factor * (p0 * e0.c + p1 * e1.c + p2 * e2.c);
+    }
+
+    float evaluate(float x, float y) const {
+      return a * x + b * y + c;
+    }
+};
+
+enum tile_coverage_e {
+  TILE_COVERAGE_NONE,
+  TILE_COVERAGE_PARTIAL,
+  TILE_COVERAGE_FULL,
+};
+
+// The edge functions are linear, so if all four corner pixel centers of a
+// tile are on the same side of an edge then every pixel center in the tile is
+// as well.
+inline tile_coverage_e classify_tile(const edge_equation_s& e0,
+                                     const edge_equation_s& e1,
+                                     const edge_equation_s& e2,
+                                     float                  x0,
+                                     float                  y0,
+                                     float                  x1,
+                                     float                  y1) {
+  const edge_equation_s* edges[] = { &e0, &e1, &e2 };
+
+  bool full = true;
+
+  for(const edge_equation_s* edge : edges) {
+    int32_t inside = edge->test(x0, y0) + edge->test(x1, y0) +
+                     edge->test(x0, y1) + edge->test(x1, y1);
+
+    if(inside == 0) {
+      return TILE_COVERAGE_NONE;
+    }
+
+    if(inside != 4) {
+      full = false;
+    }
+  }
+
+  return full ? TILE_COVERAGE_FULL : TILE_COVERAGE_PARTIAL;
+}
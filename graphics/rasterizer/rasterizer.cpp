@@ -1,7 +1,45 @@
 #include <cstdint>
+#include <iostream>
+#include <vector>
 
 #include "util.h"
+#include "framebuffer.h"
 #include "graphics/rasterizer/triangle.h"
+#include "graphics/rasterizer/depth_buffer.h"
+#include "graphics/rasterizer/texture.h"
+#include "graphics/rasterizer/vertex_layout.h"
+
+static int32_t count_mismatches(const uint32_t* reference,
+                                const uint32_t* image,
+                                int32_t         image_width,
+                                int32_t         image_height) {
+  int32_t mismatches = 0;
+
+  for(int32_t y = 0; y < image_height; y++) {
+    for(int32_t x = 0; x < image_width; x++) {
+      if(reference[x + y * image_width] != image[x + y * image_width]) {
+        mismatches++;
+      }
+    }
+  }
+
+  return mismatches;
+}
+
+// Prints how many pixels of image differ from the trenki2_p1 reference and
+// returns whether none do.
+static bool verify(const char*     name,
+                   const uint32_t* reference,
+                   const uint32_t* image,
+                   int32_t         image_width,
+                   int32_t         image_height) {
+  int32_t mismatches =
+      count_mismatches(reference, image, image_width, image_height);
+
+  std::cout << name << ": " << mismatches << " pixels differ from trenki2_p1"
+            << std::endl;
+  return mismatches == 0;
+}
 
 int32_t main(int32_t argument_count, char** arguments) {
   static constexpr int32_t IMAGE_WIDTH  = 512;
@@ -11,7 +49,16 @@ int32_t main(int32_t argument_count, char** arguments) {
   point2d_t v1{ 0, IMAGE_HEIGHT, 0.0f, 1.0f, 0.0f };
   point2d_t v2{ 0, 0, 0.0f, 0.5f, 1.0f };
 
-  uint32_t* image = new uint32_t[IMAGE_WIDTH * IMAGE_HEIGHT];
+  // The kernels take the image width as the row stride, which holds because
+  // 512 is a multiple of the framebuffer's 16 pixel row alignment.
+  framebuffer image_buffer{ IMAGE_WIDTH, IMAGE_HEIGHT };
+  framebuffer reference_buffer{ IMAGE_WIDTH, IMAGE_HEIGHT };
+
+  uint32_t* image     = image_buffer.data();
+  uint32_t* reference = reference_buffer.data();
+
+  // Cleared by any kernel whose output differs from trenki2_p1.
+  bool passed = true;
 
   /*
   clear_framebuffer(image, IMAGE_WIDTH, IMAGE_HEIGHT);
@@ -33,19 +80,119 @@ int32_t main(int32_t argument_count, char** arguments) {
   draw_triangle_joshbeam(image, IMAGE_WIDTH, IMAGE_HEIGHT, v0, v1, v2);
   write_framebuffer("out_joshbeam.ppm", image, IMAGE_WIDTH, IMAGE_HEIGHT);
 
+  clear_framebuffer(reference, IMAGE_WIDTH, IMAGE_HEIGHT);
+  draw_triangle_trenki2_p1(reference, IMAGE_WIDTH, IMAGE_HEIGHT, v0, v1, v2);
+  write_framebuffer("out_trenki2_p1.ppm", reference, IMAGE_WIDTH, IMAGE_HEIGHT);
+
   clear_framebuffer(image, IMAGE_WIDTH, IMAGE_HEIGHT);
-  draw_triangle_trenki2_p1(image, IMAGE_WIDTH, IMAGE_HEIGHT, v0, v1, v2);
-  write_framebuffer("out_trenki2_p1.ppm", image, IMAGE_WIDTH, IMAGE_HEIGHT);
+  draw_triangle_trenki2_p2(image, IMAGE_WIDTH, IMAGE_HEIGHT, v0, v1, v2);
+  write_framebuffer("out_trenki2_p2.ppm", image, IMAGE_WIDTH, IMAGE_HEIGHT);
+  passed &= verify("trenki2_p2", reference, image, IMAGE_WIDTH, IMAGE_HEIGHT);
 
-  /*
-  #if defined(__AVX2__)
+  clear_framebuffer(image, IMAGE_WIDTH, IMAGE_HEIGHT);
+  draw_triangle_simd(image, IMAGE_WIDTH, IMAGE_HEIGHT, v0, v1, v2);
+  write_framebuffer("out_simd.ppm", image, IMAGE_WIDTH, IMAGE_HEIGHT);
+  passed &= verify("simd", reference, image, IMAGE_WIDTH, IMAGE_HEIGHT);
 
-      clear_framebuffer(image, IMAGE_WIDTH, IMAGE_HEIGHT);
-      draw_triangle_avx2(image, IMAGE_WIDTH, IMAGE_HEIGHT, v0, v1, v2, color);
-      write_framebuffer("out_avx2.ppm", image, IMAGE_WIDTH, IMAGE_HEIGHT);
+  rgb_layout_t::vertex_t l0{ v0.x, v0.y, { v0.r, v0.g, v0.b } };
+  rgb_layout_t::vertex_t l1{ v1.x, v1.y, { v1.r, v1.g, v1.b } };
+  rgb_layout_t::vertex_t l2{ v2.x, v2.y, { v2.r, v2.g, v2.b } };
 
-  #endif
-  */
+  clear_framebuffer(image, IMAGE_WIDTH, IMAGE_HEIGHT);
+  draw_triangle_layout<rgb_layout_t>(image,
+                                     IMAGE_WIDTH,
+                                     IMAGE_HEIGHT,
+                                     l0,
+                                     l1,
+                                     l2,
+                                     rgb_shader_s{});
+  write_framebuffer("out_layout.ppm", image, IMAGE_WIDTH, IMAGE_HEIGHT);
+  passed &= verify("layout", reference, image, IMAGE_WIDTH, IMAGE_HEIGHT);
+
+  clear_framebuffer(image, IMAGE_WIDTH, IMAGE_HEIGHT);
+  draw_triangle_fixed(image, IMAGE_WIDTH, IMAGE_HEIGHT, v0, v1, v2);
+  write_framebuffer("out_fixed.ppm", image, IMAGE_WIDTH, IMAGE_HEIGHT);
+  passed &= verify("fixed", reference, image, IMAGE_WIDTH, IMAGE_HEIGHT);
+
+  point2d_t v3{ IMAGE_WIDTH, 0, 1.0f, 1.0f, 1.0f };
+  point2d_t batch[] = { v0, v1, v2, v2, v3, v0 };
+
+  clear_framebuffer(image, IMAGE_WIDTH, IMAGE_HEIGHT);
+  draw_triangles(image, IMAGE_WIDTH, IMAGE_HEIGHT, batch, 2);
+  write_framebuffer("out_batch.ppm", image, IMAGE_WIDTH, IMAGE_HEIGHT);
+
+  // Two triangles that cut through each other; the far vertices have a
+  // smaller 1/w so their colors are compressed towards the back.
+  vertex_t d0{ 32, 64, 0.1f, 1.0f, 1.0f, 0.0f, 0.0f };
+  vertex_t d1{ 480, 256, 0.9f, 0.25f, 1.0f, 1.0f, 0.0f };
+  vertex_t d2{ 32, 448, 0.1f, 1.0f, 1.0f, 0.0f, 0.0f };
+  vertex_t d3{ 480, 64, 0.1f, 1.0f, 0.0f, 0.0f, 1.0f };
+  vertex_t d4{ 480, 448, 0.1f, 1.0f, 0.0f, 0.0f, 1.0f };
+  vertex_t d5{ 32, 256, 0.9f, 0.25f, 0.0f, 1.0f, 1.0f };
+
+  depth_buffer_t depth{ IMAGE_WIDTH, IMAGE_HEIGHT, DEPTH_FORMAT_FLOAT32 };
+
+  clear_framebuffer(image, IMAGE_WIDTH, IMAGE_HEIGHT);
+  draw_triangle_depth(image, depth, d0, d1, d2);
+  draw_triangle_depth(image, depth, d3, d4, d5);
+  write_framebuffer("out_depth.ppm", image, IMAGE_WIDTH, IMAGE_HEIGHT);
+
+  // A 64x64 checkerboard repeated eight times across a quad rotated by 30
+  // degrees; the quad is minified, so the sampler picks a coarser mip level.
+  std::vector<uint32_t> checker(64 * 64);
+
+  for(int32_t y = 0; y < 64; y++) {
+    for(int32_t x = 0; x < 64; x++) {
+      bool odd = ((x / 8) + (y / 8)) & 1;
+
+      checker[x + y * 64] =
+          odd ? pack_color(255, 255, 255, 255) : pack_color(32, 32, 160, 255);
+    }
+  }
+
+  texture_t texture{ checker.data(), 64, 64, TEXTURE_LAYOUT_MORTON };
+
+  uv_layout_t::vertex_t t0{ 192, 32, { 0, 0 } };
+  uv_layout_t::vertex_t t1{ 414, 160, { 8, 0 } };
+  uv_layout_t::vertex_t t2{ 286, 382, { 8, 8 } };
+  uv_layout_t::vertex_t t3{ 64, 254, { 0, 8 } };
+
+  clear_framebuffer(image, IMAGE_WIDTH, IMAGE_HEIGHT);
+  draw_triangle_textured(image,
+                         IMAGE_WIDTH,
+                         IMAGE_HEIGHT,
+                         t0,
+                         t1,
+                         t2,
+                         texture,
+                         TEXTURE_FILTER_BILINEAR);
+  draw_triangle_textured(image,
+                         IMAGE_WIDTH,
+                         IMAGE_HEIGHT,
+                         t2,
+                         t3,
+                         t0,
+                         texture,
+                         TEXTURE_FILTER_BILINEAR);
+  write_framebuffer("out_textured.ppm", image, IMAGE_WIDTH, IMAGE_HEIGHT);
+
+#if defined(__x86_64__)
+
+  if(__builtin_cpu_supports("avx2")) {
+    clear_framebuffer(image, IMAGE_WIDTH, IMAGE_HEIGHT);
+    draw_triangle_avx2(image, IMAGE_WIDTH, IMAGE_HEIGHT, v0, v1, v2);
+    write_framebuffer("out_avx2.ppm", image, IMAGE_WIDTH, IMAGE_HEIGHT);
+    passed &= verify("avx2", reference, image, IMAGE_WIDTH, IMAGE_HEIGHT);
+  }
+
+  if(__builtin_cpu_supports("avx512f")) {
+    clear_framebuffer(image, IMAGE_WIDTH, IMAGE_HEIGHT);
+    draw_triangle_avx512(image, IMAGE_WIDTH, IMAGE_HEIGHT, v0, v1, v2);
+    write_framebuffer("out_avx512.ppm", image, IMAGE_WIDTH, IMAGE_HEIGHT);
+    passed &= verify("avx512", reference, image, IMAGE_WIDTH, IMAGE_HEIGHT);
+  }
+
+#endif
 
-  return 0;
+  return passed ? 0 : 1;
 }
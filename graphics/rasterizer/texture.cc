@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "util.h"
+#include "graphics/rasterizer/texture.h"
+
+// Channels of color in pack_color order, red first.
+static void unpack_channels(uint32_t color, uint8_t* channels) {
+  unpack_color(color, &channels[0], &channels[1], &channels[2], &channels[3]);
+}
+
+static bool is_power_of_two(int32_t value) {
+  return value > 0 && (value & (value - 1)) == 0;
+}
+
+static int32_t log2_floor(int32_t value) {
+  int32_t result = 0;
+
+  while((1 << (result + 1)) <= value) {
+    result++;
+  }
+
+  return result;
+}
+
+texture_t::texture_t(const uint32_t*  pixels,
+                     int32_t          width,
+                     int32_t          height,
+                     texture_layout_e layout)
+  : layout{ layout } {
+  // Repeat addressing masks coordinates and the Morton index interleaves
+  // whole bits, and both need every level to halve exactly.
+  assert(is_power_of_two(width) && is_power_of_two(height));
+
+  std::vector<uint32_t> source(pixels, pixels + width * height);
+
+  size_t offset = 0;
+
+  while(true) {
+    texture_level_t level{ width,
+                           height,
+                           log2_floor(std::min(width, height)),
+                           offset };
+
+    levels.push_back(level);
+    texels.resize(offset + width * height);
+
+    for(int32_t y = 0; y < height; y++) {
+      for(int32_t x = 0; x < width; x++) {
+        texels[texel_index(level, x, y)] = source[x + y * width];
+      }
+    }
+
+    offset += width * height;
+
+    if(width == 1 && height == 1) {
+      break;
+    }
+
+    int32_t next_width  = std::max(width / 2, 1);
+    int32_t next_height = std::max(height / 2, 1);
+
+    std::vector<uint32_t> next(next_width * next_height);
+
+    for(int32_t y = 0; y < next_height; y++) {
+      for(int32_t x = 0; x < next_width; x++) {
+        int32_t x0 = std::min(x * 2, width - 1);
+        int32_t y0 = std::min(y * 2, height - 1);
+        int32_t x1 = std::min(x * 2 + 1, width - 1);
+        int32_t y1 = std::min(y * 2 + 1, height - 1);
+
+        uint8_t c00[4];
+        uint8_t c10[4];
+        uint8_t c01[4];
+        uint8_t c11[4];
+
+        unpack_channels(source[x0 + y0 * width], c00);
+        unpack_channels(source[x1 + y0 * width], c10);
+        unpack_channels(source[x0 + y1 * width], c01);
+        unpack_channels(source[x1 + y1 * width], c11);
+
+        uint8_t average[4];
+
+        for(int32_t index = 0; index < 4; index++) {
+          uint32_t sum = c00[index] + c10[index] + c01[index] + c11[index];
+          average[index] = (sum + 2) / 4;
+        }
+
+        next[x + y * next_width] =
+            pack_color(average[0], average[1], average[2], average[3]);
+      }
+    }
+
+    source = std::move(next);
+    width  = next_width;
+    height = next_height;
+  }
+}
+
+int32_t texture_t::select_level(float du_dx,
+                                float dv_dx,
+                                float du_dy,
+                                float dv_dy) const {
+  float width  = (float)levels[0].width;
+  float height = (float)levels[0].height;
+
+  float length_x = std::hypot(du_dx * width, dv_dx * height);
+  float length_y = std::hypot(du_dy * width, dv_dy * height);
+  float rho      = std::max(length_x, length_y);
+
+  if(rho <= 1.0f) {
+    return 0;
+  }
+
+  int32_t level = (int32_t)std::lround(std::log2(rho));
+
+  return std::min(level, (int32_t)levels.size() - 1);
+}
+
+uint32_t texture_t::sample(float            u,
+                           float            v,
+                           int32_t          level_index,
+                           texture_filter_e filter) const {
+  const texture_level_t& level = levels[level_index];
+
+  float x = u * level.width;
+  float y = v * level.height;
+
+  if(filter == TEXTURE_FILTER_NEAREST) {
+    return fetch(level_index, (int32_t)std::floor(x), (int32_t)std::floor(y));
+  }
+
+  x -= 0.5f;
+  y -= 0.5f;
+
+  float floor_x = std::floor(x);
+  float floor_y = std::floor(y);
+  float fx      = x - floor_x;
+  float fy      = y - floor_y;
+
+  int32_t x0 = (int32_t)floor_x;
+  int32_t y0 = (int32_t)floor_y;
+
+  uint8_t c00[4];
+  uint8_t c10[4];
+  uint8_t c01[4];
+  uint8_t c11[4];
+
+  unpack_channels(fetch(level_index, x0, y0), c00);
+  unpack_channels(fetch(level_index, x0 + 1, y0), c10);
+  unpack_channels(fetch(level_index, x0, y0 + 1), c01);
+  unpack_channels(fetch(level_index, x0 + 1, y0 + 1), c11);
+
+  uint8_t result[4];
+
+  for(int32_t index = 0; index < 4; index++) {
+    float top    = c00[index] + (c10[index] - (float)c00[index]) * fx;
+    float bottom = c01[index] + (c11[index] - (float)c01[index]) * fx;
+
+    result[index] = (uint8_t)(top + (bottom - top) * fy + 0.5f);
+  }
+
+  return pack_color(result[0], result[1], result[2], result[3]);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "graphics/rasterizer/vertex_layout.h"
+
+enum texture_layout_e {
+  TEXTURE_LAYOUT_LINEAR,
+  TEXTURE_LAYOUT_MORTON,
+};
+
+enum texture_filter_e {
+  TEXTURE_FILTER_NEAREST,
+  TEXTURE_FILTER_BILINEAR,
+};
+
+struct texture_level_t {
+    int32_t width;
+    int32_t height;
+    int32_t morton_bits;
+    size_t  offset;
+};
+
+// Spreads the low 16 bits of value out to the even bit positions.
+inline uint32_t morton_spread(uint32_t value) {
+  value &= 0x0000FFFF;
+  value = (value | (value << 8)) & 0x00FF00FF;
+  value = (value | (value << 4)) & 0x0F0F0F0F;
+  value = (value | (value << 2)) & 0x33333333;
+  value = (value | (value << 1)) & 0x55555555;
+  return value;
+}
+
+// Mip-mapped texture of packed pixels (see pack_color) with power-of-two
+// dimensions and repeat addressing. In the Morton layout the texels of every
+// level are stored in Z-order, so a 2x2 bilinear footprint and any short walk
+// across the texture stay within a few cache lines whatever direction the
+// walk takes. Non-square levels interleave the bits of the shorter side and
+// put the remaining bits of the longer side on top.
+struct texture_t {
+    texture_layout_e             layout;
+    std::vector<texture_level_t> levels;
+    std::vector<uint32_t>        texels;
+
+    texture_t(const uint32_t*  pixels,
+              int32_t          width,
+              int32_t          height,
+              texture_layout_e layout);
+
+    size_t texel_index(const texture_level_t& level,
+                       uint32_t               x,
+                       uint32_t               y) const {
+      if(layout == TEXTURE_LAYOUT_LINEAR) {
+        return level.offset + x + y * level.width;
+      }
+
+      uint32_t mask  = (1u << level.morton_bits) - 1;
+      uint32_t low   = morton_spread(x & mask) | (morton_spread(y & mask) << 1);
+      uint32_t high  = (x | y) >> level.morton_bits;
+      size_t   index = low + ((size_t)high << (2 * level.morton_bits));
+
+      return level.offset + index;
+    }
+
+    uint32_t fetch(int32_t level_index, int32_t x, int32_t y) const {
+      const texture_level_t& level = levels[level_index];
+
+      uint32_t wrapped_x = (uint32_t)x & (level.width - 1);
+      uint32_t wrapped_y = (uint32_t)y & (level.height - 1);
+
+      return texels[texel_index(level, wrapped_x, wrapped_y)];
+    }
+
+    // Picks the mip level from the screen-space derivatives of the texture
+    // coordinates (in normalized units), rounded to the nearest level.
+    int32_t select_level(float du_dx,
+                         float dv_dx,
+                         float du_dy,
+                         float dv_dy) const;
+
+    uint32_t sample(float            u,
+                    float            v,
+                    int32_t          level_index,
+                    texture_filter_e filter) const;
+};
+
+using uv_layout_t = vertex_layout_t<2>;
+
+void draw_triangle_textured(uint32_t*                    image,
+                            int32_t                      image_width,
+                            int32_t                      image_height,
+                            const uv_layout_t::vertex_t& v0,
+                            const uv_layout_t::vertex_t& v1,
+                            const uv_layout_t::vertex_t& v2,
+                            const texture_t&             texture,
+                            texture_filter_e             filter);
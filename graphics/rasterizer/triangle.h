@@ -1,7 +1,11 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
+class thread_pool;
+struct depth_buffer_t;
+
 struct point2d_t {
     float x;
     float y;
@@ -11,6 +15,28 @@ struct point2d_t {
     float b;
 };
 
+// Screen-space vertex for depth-tested drawing. z is the depth in [0, 1]
+// (smaller is closer) and inverse_w is 1/w from the projection, used to
+// interpolate the colors perspective-correctly.
+struct vertex_t {
+    float x;
+    float y;
+    float z;
+    float inverse_w;
+
+    float r;
+    float g;
+    float b;
+};
+
+// Half-open pixel rectangle, [min_x, max_x) x [min_y, max_y).
+struct rect_t {
+    int32_t min_x;
+    int32_t min_y;
+    int32_t max_x;
+    int32_t max_y;
+};
+
 void draw_triangle_joshbeam(uint32_t*        image,
                             int32_t          image_width,
                             int32_t          image_height,
@@ -23,3 +49,76 @@ void draw_triangle_trenki2_p1(uint32_t*        image,
                               const point2d_t& v0,
                               const point2d_t& v1,
                               const point2d_t& v2);
+void draw_triangle_trenki2_p2(uint32_t*        image,
+                              int32_t          image_width,
+                              int32_t          image_height,
+                              const point2d_t& v0,
+                              const point2d_t& v1,
+                              const point2d_t& v2);
+void draw_triangle_trenki2_p2(uint32_t*        image,
+                              int32_t          image_width,
+                              const rect_t&    clip,
+                              const point2d_t& v0,
+                              const point2d_t& v1,
+                              const point2d_t& v2);
+
+// Snaps vertices to 28.4 fixed point and steps integer edge functions with an
+// exact top-left fill rule, so triangles sharing an edge never both cover a
+// pixel on it and never leave a gap between them.
+void draw_triangle_fixed(uint32_t*        image,
+                         int32_t          image_width,
+                         int32_t          image_height,
+                         const point2d_t& v0,
+                         const point2d_t& v1,
+                         const point2d_t& v2);
+
+// Depth-tested (less) drawing into an image of the depth buffer's size.
+// Tiles whose nearest possible depth is behind the farthest value already
+// stored are skipped before any pixel is shaded.
+void draw_triangle_depth(uint32_t*       image,
+                         depth_buffer_t& depth,
+                         const vertex_t& v0,
+                         const vertex_t& v1,
+                         const vertex_t& v2);
+
+// Draws count triangles stored as consecutive vertex triples. Triangles are
+// binned into screen tiles and the tiles rasterized in parallel; every tile
+// is owned by one thread and draws its triangles in submission order, so the
+// result matches drawing them one by one.
+void draw_triangles(uint32_t*        image,
+                    int32_t          image_width,
+                    int32_t          image_height,
+                    const point2d_t* vertices,
+                    size_t           count);
+void draw_triangles(thread_pool&     pool,
+                    uint32_t*        image,
+                    int32_t          image_width,
+                    int32_t          image_height,
+                    const point2d_t* vertices,
+                    size_t           count);
+
+// Picks the widest kernel the running CPU supports, falling back to
+// draw_triangle_trenki2_p2.
+void draw_triangle_simd(uint32_t*        image,
+                        int32_t          image_width,
+                        int32_t          image_height,
+                        const point2d_t& v0,
+                        const point2d_t& v1,
+                        const point2d_t& v2);
+
+#if defined(__x86_64__)
+
+void draw_triangle_avx2(uint32_t*        image,
+                        int32_t          image_width,
+                        int32_t          image_height,
+                        const point2d_t& v0,
+                        const point2d_t& v1,
+                        const point2d_t& v2);
+void draw_triangle_avx512(uint32_t*        image,
+                          int32_t          image_width,
+                          int32_t          image_height,
+                          const point2d_t& v0,
+                          const point2d_t& v1,
+                          const point2d_t& v2);
+
+#endif
@@ -0,0 +1,109 @@
+#if defined(__x86_64__)
+
+# include <algorithm>
+# include <cmath>
+
+# include <immintrin.h>
+
+# include "graphics/rasterizer/triangle.h"
+# include "graphics/rasterizer/edge_equation.h"
+
+# define TARGET_AVX2 __attribute__((target("avx2")))
+
+TARGET_AVX2 static inline __m256 evaluate_avx2(float  a,
+                                               __m256 x,
+                                               float  by,
+                                               float  c) {
+  __m256 ax = _mm256_mul_ps(_mm256_set1_ps(a), x);
+  return _mm256_add_ps(_mm256_add_ps(ax, _mm256_set1_ps(by)),
+                       _mm256_set1_ps(c));
+}
+
+TARGET_AVX2 static inline __m256i test_avx2(const edge_equation_s& edge,
+                                            __m256                 x,
+                                            float                  y) {
+  __m256 zero  = _mm256_setzero_ps();
+  __m256 value = evaluate_avx2(edge.a, x, edge.b * y, edge.c);
+  __m256 mask  = _mm256_cmp_ps(value, zero, _CMP_GT_OQ);
+
+  if(edge.tie) {
+    mask = _mm256_or_ps(mask, _mm256_cmp_ps(value, zero, _CMP_EQ_OQ));
+  }
+
+  return _mm256_castps_si256(mask);
+}
+
+TARGET_AVX2 static inline __m256i channel_avx2(const parameter_equation_s& p,
+                                               __m256                      x,
+                                               float                       y) {
+  __m256 value = evaluate_avx2(p.a, x, p.b * y, p.c);
+  value        = _mm256_mul_ps(value, _mm256_set1_ps(255.0f));
+
+  return _mm256_and_si256(_mm256_cvttps_epi32(value), _mm256_set1_epi32(0xFF));
+}
+
+TARGET_AVX2 void draw_triangle_avx2(uint32_t*        image,
+                                    int32_t          image_width,
+                                    int32_t          image_height,
+                                    const point2d_t& v0,
+                                    const point2d_t& v1,
+                                    const point2d_t& v2) {
+  edge_equation_s e0(v1, v2);
+  edge_equation_s e1(v2, v0);
+  edge_equation_s e2(v0, v1);
+
+  float area = 0.5f * (e0.c + e1.c + e2.c);
+
+  if(area < 0.0f) {
+    return;
+  }
+
+  parameter_equation_s r(v0.r, v1.r, v2.r, e0, e1, e2, area);
+  parameter_equation_s g(v0.g, v1.g, v2.g, e0, e1, e2, area);
+  parameter_equation_s b(v0.b, v1.b, v2.b, e0, e1, e2, area);
+
+  int32_t min_x = (int32_t)std::floor(std::min({ v0.x, v1.x, v2.x }));
+  int32_t min_y = (int32_t)std::floor(std::min({ v0.y, v1.y, v2.y }));
+  int32_t max_x = (int32_t)std::ceil(std::max({ v0.x, v1.x, v2.x }));
+  int32_t max_y = (int32_t)std::ceil(std::max({ v0.y, v1.y, v2.y }));
+
+  min_x = std::max(min_x, 0);
+  min_y = std::max(min_y, 0);
+  max_x = std::min(max_x, image_width);
+  max_y = std::min(max_y, image_height);
+
+  const __m256i lanes   = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i alpha   = _mm256_set1_epi32(0xFF000000);
+  const __m256  centers = _mm256_add_ps(_mm256_cvtepi32_ps(lanes),
+                                        _mm256_set1_ps(0.5f));
+
+  for(int32_t y_coord = min_y; y_coord < max_y; y_coord++) {
+    float     y   = y_coord + 0.5f;
+    uint32_t* row = image + y_coord * image_width;
+
+    for(int32_t x_coord = min_x; x_coord < max_x; x_coord += 8) {
+      __m256 x = _mm256_add_ps(_mm256_set1_ps((float)x_coord), centers);
+
+      __m256i limit = _mm256_set1_epi32(max_x - x_coord);
+      __m256i mask  = _mm256_cmpgt_epi32(limit, lanes);
+
+      mask = _mm256_and_si256(mask, test_avx2(e0, x, y));
+      mask = _mm256_and_si256(mask, test_avx2(e1, x, y));
+      mask = _mm256_and_si256(mask, test_avx2(e2, x, y));
+
+      if(_mm256_testz_si256(mask, mask)) {
+        continue;
+      }
+
+      __m256i red   = channel_avx2(r, x, y);
+      __m256i green = _mm256_slli_epi32(channel_avx2(g, x, y), 8);
+      __m256i blue  = _mm256_slli_epi32(channel_avx2(b, x, y), 16);
+      __m256i color = _mm256_or_si256(_mm256_or_si256(red, green),
+                                      _mm256_or_si256(blue, alpha));
+
+      _mm256_maskstore_epi32((int32_t*)(row + x_coord), mask, color);
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,111 @@
+#if defined(__x86_64__)
+
+# include <algorithm>
+# include <cmath>
+
+# include <immintrin.h>
+
+# include "graphics/rasterizer/triangle.h"
+# include "graphics/rasterizer/edge_equation.h"
+
+# define TARGET_AVX512 __attribute__((target("avx512f")))
+
+TARGET_AVX512 static inline __m512 evaluate_avx512(float  a,
+                                                   __m512 x,
+                                                   float  by,
+                                                   float  c) {
+  __m512 ax = _mm512_mul_ps(_mm512_set1_ps(a), x);
+  return _mm512_add_ps(_mm512_add_ps(ax, _mm512_set1_ps(by)),
+                       _mm512_set1_ps(c));
+}
+
+TARGET_AVX512 static inline __mmask16 test_avx512(const edge_equation_s& edge,
+                                                  __m512                 x,
+                                                  float                  y) {
+  __m512    zero  = _mm512_setzero_ps();
+  __m512    value = evaluate_avx512(edge.a, x, edge.b * y, edge.c);
+  __mmask16 mask  = _mm512_cmp_ps_mask(value, zero, _CMP_GT_OQ);
+
+  if(edge.tie) {
+    mask |= _mm512_cmp_ps_mask(value, zero, _CMP_EQ_OQ);
+  }
+
+  return mask;
+}
+
+TARGET_AVX512 static inline __m512i channel_avx512(
+    const parameter_equation_s& p,
+    __m512                      x,
+    float                       y) {
+  __m512 value = evaluate_avx512(p.a, x, p.b * y, p.c);
+  value        = _mm512_mul_ps(value, _mm512_set1_ps(255.0f));
+
+  return _mm512_and_si512(_mm512_cvttps_epi32(value), _mm512_set1_epi32(0xFF));
+}
+
+TARGET_AVX512 void draw_triangle_avx512(uint32_t*        image,
+                                        int32_t          image_width,
+                                        int32_t          image_height,
+                                        const point2d_t& v0,
+                                        const point2d_t& v1,
+                                        const point2d_t& v2) {
+  edge_equation_s e0(v1, v2);
+  edge_equation_s e1(v2, v0);
+  edge_equation_s e2(v0, v1);
+
+  float area = 0.5f * (e0.c + e1.c + e2.c);
+
+  if(area < 0.0f) {
+    return;
+  }
+
+  parameter_equation_s r(v0.r, v1.r, v2.r, e0, e1, e2, area);
+  parameter_equation_s g(v0.g, v1.g, v2.g, e0, e1, e2, area);
+  parameter_equation_s b(v0.b, v1.b, v2.b, e0, e1, e2, area);
+
+  int32_t min_x = (int32_t)std::floor(std::min({ v0.x, v1.x, v2.x }));
+  int32_t min_y = (int32_t)std::floor(std::min({ v0.y, v1.y, v2.y }));
+  int32_t max_x = (int32_t)std::ceil(std::max({ v0.x, v1.x, v2.x }));
+  int32_t max_y = (int32_t)std::ceil(std::max({ v0.y, v1.y, v2.y }));
+
+  min_x = std::max(min_x, 0);
+  min_y = std::max(min_y, 0);
+  max_x = std::min(max_x, image_width);
+  max_y = std::min(max_y, image_height);
+
+  const __m512i lanes =
+      _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  const __m512i alpha   = _mm512_set1_epi32(0xFF000000);
+  const __m512  offsets = _mm512_maskz_cvtepi32_ps(0xFFFF, lanes);
+  const __m512  centers = _mm512_add_ps(offsets, _mm512_set1_ps(0.5f));
+
+  for(int32_t y_coord = min_y; y_coord < max_y; y_coord++) {
+    float     y   = y_coord + 0.5f;
+    uint32_t* row = image + y_coord * image_width;
+
+    for(int32_t x_coord = min_x; x_coord < max_x; x_coord += 16) {
+      __m512 x = _mm512_add_ps(_mm512_set1_ps((float)x_coord), centers);
+
+      int32_t   remaining = max_x - x_coord;
+      __mmask16 mask      = remaining < 16 ? (1u << remaining) - 1 : 0xFFFF;
+
+      mask &= test_avx512(e0, x, y);
+      mask &= test_avx512(e1, x, y);
+      mask &= test_avx512(e2, x, y);
+
+      if(mask == 0) {
+        continue;
+      }
+
+      __m512i red   = channel_avx512(r, x, y);
+      __m512i green = _mm512_slli_epi32(channel_avx512(g, x, y), 8);
+      __m512i blue  = _mm512_slli_epi32(channel_avx512(b, x, y), 16);
+      __m512i color = _mm512_or_si512(_mm512_or_si512(red, green),
+                                      _mm512_or_si512(blue, alpha));
+
+      _mm512_mask_storeu_epi32(row + x_coord, mask, color);
+    }
+  }
+}
+
+#endif
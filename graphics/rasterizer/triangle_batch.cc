@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "thread_pool.h"
+#include "graphics/rasterizer/triangle.h"
+
+static constexpr int32_t BIN_SIZE = 64;
+
+void draw_triangles(thread_pool&     pool,
+                    uint32_t*        image,
+                    int32_t          image_width,
+                    int32_t          image_height,
+                    const point2d_t* vertices,
+                    size_t           count) {
+  int32_t bins_x = (image_width + BIN_SIZE - 1) / BIN_SIZE;
+  int32_t bins_y = (image_height + BIN_SIZE - 1) / BIN_SIZE;
+
+  std::vector<std::vector<uint32_t>> bins(bins_x * bins_y);
+
+  for(size_t index = 0; index < count; index++) {
+    const point2d_t& v0 = vertices[index * 3 + 0];
+    const point2d_t& v1 = vertices[index * 3 + 1];
+    const point2d_t& v2 = vertices[index * 3 + 2];
+
+    int32_t min_x = (int32_t)std::floor(std::min({ v0.x, v1.x, v2.x }));
+    int32_t min_y = (int32_t)std::floor(std::min({ v0.y, v1.y, v2.y }));
+    int32_t max_x = (int32_t)std::ceil(std::max({ v0.x, v1.x, v2.x }));
+    int32_t max_y = (int32_t)std::ceil(std::max({ v0.y, v1.y, v2.y }));
+
+    min_x = std::max(min_x, 0);
+    min_y = std::max(min_y, 0);
+    max_x = std::min(max_x, image_width);
+    max_y = std::min(max_y, image_height);
+
+    if(min_x >= max_x || min_y >= max_y) {
+      continue;
+    }
+
+    for(int32_t bin_y = min_y / BIN_SIZE; bin_y <= (max_y - 1) / BIN_SIZE;
+        bin_y++) {
+      for(int32_t bin_x = min_x / BIN_SIZE; bin_x <= (max_x - 1) / BIN_SIZE;
+          bin_x++) {
+        bins[bin_x + bin_y * bins_x].push_back(index);
+      }
+    }
+  }
+
+  pool.parallel_for(bins.size(), [&](size_t bin_index) {
+    const std::vector<uint32_t>& bin = bins[bin_index];
+
+    int32_t bin_x = bin_index % bins_x;
+    int32_t bin_y = bin_index / bins_x;
+
+    rect_t clip{ bin_x * BIN_SIZE,
+                 bin_y * BIN_SIZE,
+                 std::min((bin_x + 1) * BIN_SIZE, image_width),
+                 std::min((bin_y + 1) * BIN_SIZE, image_height) };
+
+    for(uint32_t index : bin) {
+      draw_triangle_trenki2_p2(image,
+                               image_width,
+                               clip,
+                               vertices[index * 3 + 0],
+                               vertices[index * 3 + 1],
+                               vertices[index * 3 + 2]);
+    }
+  });
+}
+
+void draw_triangles(uint32_t*        image,
+                    int32_t          image_width,
+                    int32_t          image_height,
+                    const point2d_t* vertices,
+                    size_t           count) {
+  static thread_pool pool;
+
+  draw_triangles(pool, image, image_width, image_height, vertices, count);
+}
@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <cmath>
+
+#include "util.h"
+#include "graphics/rasterizer/triangle.h"
+#include "graphics/rasterizer/edge_equation.h"
+#include "graphics/rasterizer/depth_buffer.h"
+
+static constexpr int32_t TILE_SIZE = depth_buffer_t::TILE_SIZE;
+
+struct unorm16_depth_s {
+    using value_t = uint16_t;
+
+    static value_t encode(float z) {
+      return (value_t)(std::clamp(z, 0.0f, 1.0f) * UINT16_MAX + 0.5f);
+    }
+
+    static float decode(value_t value) {
+      return value * (1.0f / UINT16_MAX);
+    }
+
+    static value_t* values(depth_buffer_t& depth) {
+      return depth.unorm16.data();
+    }
+};
+
+struct float32_depth_s {
+    using value_t = float;
+
+    static value_t encode(float z) {
+      return z;
+    }
+
+    static float decode(value_t value) {
+      return value;
+    }
+
+    static value_t* values(depth_buffer_t& depth) {
+      return depth.float32.data();
+    }
+};
+
+template <typename format_s>
+static void draw_triangle_depth(uint32_t*       image,
+                                depth_buffer_t& depth,
+                                const vertex_t& v0,
+                                const vertex_t& v1,
+                                const vertex_t& v2) {
+  using value_t = typename format_s::value_t;
+
+  edge_equation_s e0(v1, v2);
+  edge_equation_s e1(v2, v0);
+  edge_equation_s e2(v0, v1);
+
+  float area = 0.5f * (e0.c + e1.c + e2.c);
+
+  if(area <= 0.0f) {
+    return;
+  }
+
+  // Screen-space depth is affine and interpolated directly. The colors are
+  // interpolated as r/w, g/w and b/w together with 1/w and divided per pixel,
+  // which makes them perspective-correct.
+  parameter_equation_s z(v0.z, v1.z, v2.z, e0, e1, e2, area);
+  parameter_equation_s w(v0.inverse_w,
+                         v1.inverse_w,
+                         v2.inverse_w,
+                         e0,
+                         e1,
+                         e2,
+                         area);
+  parameter_equation_s r(v0.r * v0.inverse_w,
+                         v1.r * v1.inverse_w,
+                         v2.r * v2.inverse_w,
+                         e0,
+                         e1,
+                         e2,
+                         area);
+  parameter_equation_s g(v0.g * v0.inverse_w,
+                         v1.g * v1.inverse_w,
+                         v2.g * v2.inverse_w,
+                         e0,
+                         e1,
+                         e2,
+                         area);
+  parameter_equation_s b(v0.b * v0.inverse_w,
+                         v1.b * v1.inverse_w,
+                         v2.b * v2.inverse_w,
+                         e0,
+                         e1,
+                         e2,
+                         area);
+
+  float min_z = std::min({ v0.z, v1.z, v2.z });
+
+  int32_t min_x = (int32_t)std::floor(std::min({ v0.x, v1.x, v2.x }));
+  int32_t min_y = (int32_t)std::floor(std::min({ v0.y, v1.y, v2.y }));
+  int32_t max_x = (int32_t)std::ceil(std::max({ v0.x, v1.x, v2.x }));
+  int32_t max_y = (int32_t)std::ceil(std::max({ v0.y, v1.y, v2.y }));
+
+  min_x = std::max(min_x, 0);
+  min_y = std::max(min_y, 0);
+  max_x = std::min(max_x, depth.width);
+  max_y = std::min(max_y, depth.height);
+
+  value_t* values = format_s::values(depth);
+
+  for(int32_t tile_y = min_y & ~(TILE_SIZE - 1); tile_y < max_y;
+      tile_y += TILE_SIZE) {
+    float* tile_row = &depth.tile_max[tile_y / TILE_SIZE * depth.tiles_x];
+
+    for(int32_t tile_x = min_x & ~(TILE_SIZE - 1); tile_x < max_x;
+        tile_x += TILE_SIZE) {
+      float x0 = tile_x + 0.5f;
+      float y0 = tile_y + 0.5f;
+      float x1 = tile_x + TILE_SIZE - 0.5f;
+      float y1 = tile_y + TILE_SIZE - 0.5f;
+
+      tile_coverage_e coverage = classify_tile(e0, e1, e2, x0, y0, x1, y1);
+
+      if(coverage == TILE_COVERAGE_NONE) {
+        continue;
+      }
+
+      // Hierarchical z: the depth plane is smallest at one of the tile's
+      // corner samples, so if even that is behind the farthest value already
+      // in the tile nothing in it can pass.
+      float& tile_max   = tile_row[tile_x / TILE_SIZE];
+      float  tile_min_z = std::min({ z.evaluate(x0, y0),
+                                     z.evaluate(x1, y0),
+                                     z.evaluate(x0, y1),
+                                     z.evaluate(x1, y1) });
+
+      if(std::max(tile_min_z, min_z) >= tile_max) {
+        continue;
+      }
+
+      int32_t start_x = std::max(tile_x, min_x);
+      int32_t start_y = std::max(tile_y, min_y);
+      int32_t end_x   = std::min(tile_x + TILE_SIZE, max_x);
+      int32_t end_y   = std::min(tile_y + TILE_SIZE, max_y);
+
+      bool written = false;
+
+      for(int32_t y_coord = start_y; y_coord < end_y; y_coord++) {
+        float y = y_coord + 0.5f;
+
+        for(int32_t x_coord = start_x; x_coord < end_x; x_coord++) {
+          float x = x_coord + 0.5f;
+
+          if(coverage != TILE_COVERAGE_FULL &&
+             !(e0.test(x, y) && e1.test(x, y) && e2.test(x, y))) {
+            continue;
+          }
+
+          int32_t index   = y_coord * depth.width + x_coord;
+          value_t encoded = format_s::encode(z.evaluate(x, y));
+
+          if(encoded >= values[index]) {
+            continue;
+          }
+
+          values[index] = encoded;
+
+          float pixel_w = 1.0f / w.evaluate(x, y);
+
+          int32_t r_color = (int32_t)(r.evaluate(x, y) * pixel_w * 255);
+          int32_t g_color = (int32_t)(g.evaluate(x, y) * pixel_w * 255);
+          int32_t b_color = (int32_t)(b.evaluate(x, y) * pixel_w * 255);
+
+          image[index] = pack_color(r_color, g_color, b_color, 255);
+          written      = true;
+        }
+      }
+
+      if(!written) {
+        continue;
+      }
+
+      int32_t tile_end_x = std::min(tile_x + TILE_SIZE, depth.width);
+      int32_t tile_end_y = std::min(tile_y + TILE_SIZE, depth.height);
+      value_t farthest   = 0;
+
+      for(int32_t y_coord = tile_y; y_coord < tile_end_y; y_coord++) {
+        value_t* row = values + y_coord * depth.width;
+
+        for(int32_t x_coord = tile_x; x_coord < tile_end_x; x_coord++) {
+          farthest = std::max(farthest, row[x_coord]);
+        }
+      }
+
+      tile_max = format_s::decode(farthest);
+    }
+  }
+}
+
+void draw_triangle_depth(uint32_t*       image,
+                         depth_buffer_t& depth,
+                         const vertex_t& v0,
+                         const vertex_t& v1,
+                         const vertex_t& v2) {
+  if(depth.format == DEPTH_FORMAT_UNORM16) {
+    draw_triangle_depth<unorm16_depth_s>(image, depth, v0, v1, v2);
+  } else {
+    draw_triangle_depth<float32_depth_s>(image, depth, v0, v1, v2);
+  }
+}
@@ -0,0 +1,35 @@
+#include "graphics/rasterizer/triangle.h"
+
+using draw_triangle_t = void (*)(uint32_t*        image,
+                                 int32_t          image_width,
+                                 int32_t          image_height,
+                                 const point2d_t& v0,
+                                 const point2d_t& v1,
+                                 const point2d_t& v2);
+
+static draw_triangle_t select_draw_triangle() {
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+
+  if(__builtin_cpu_supports("avx512f")) {
+    return draw_triangle_avx512;
+  }
+
+  if(__builtin_cpu_supports("avx2")) {
+    return draw_triangle_avx2;
+  }
+#endif
+
+  return draw_triangle_trenki2_p2;
+}
+
+void draw_triangle_simd(uint32_t*        image,
+                        int32_t          image_width,
+                        int32_t          image_height,
+                        const point2d_t& v0,
+                        const point2d_t& v1,
+                        const point2d_t& v2) {
+  static const draw_triangle_t draw_triangle = select_draw_triangle();
+
+  draw_triangle(image, image_width, image_height, v0, v1, v2);
+}
@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "graphics/rasterizer/triangle.h"
+
+// Conformance test for the top-left fill rule of draw_triangle_fixed: meshes
+// that tile the whole image are drawn one triangle at a time, and every pixel
+// has to be written by exactly one of them. Shared edges run at every slope,
+// and the pixel-center variants put vertices and edges exactly on the sample
+// points, where the rule has to break ties.
+
+static constexpr int32_t IMAGE_WIDTH  = 256;
+static constexpr int32_t IMAGE_HEIGHT = 192;
+
+class coverage_counter {
+  public:
+    coverage_counter()
+      : scratch(IMAGE_WIDTH * IMAGE_HEIGHT),
+        coverage(IMAGE_WIDTH * IMAGE_HEIGHT, 0) {}
+
+    void draw(const point2d_t& v0,
+              const point2d_t& v1,
+              const point2d_t& v2) {
+      std::fill(scratch.begin(), scratch.end(), 0);
+      draw_triangle_fixed(scratch.data(),
+                          IMAGE_WIDTH,
+                          IMAGE_HEIGHT,
+                          v0,
+                          v1,
+                          v2);
+
+      for(size_t index = 0; index < scratch.size(); index++) {
+        coverage[index] += scratch[index] != 0;
+      }
+    }
+
+    // Prints the gaps and double-written pixels and returns whether there
+    // were none.
+    bool check(const char* name) const {
+      int32_t gaps     = std::count(coverage.begin(), coverage.end(), 0);
+      int32_t overlaps = std::count_if(coverage.begin(),
+                                       coverage.end(),
+                                       [](int32_t count) {
+                                         return count > 1;
+                                       });
+
+      if(gaps == 0 && overlaps == 0) {
+        return true;
+      }
+
+      std::cerr << name << ": " << gaps << " gaps, " << overlaps
+                << " double-written pixels" << std::endl;
+      return false;
+    }
+
+  private:
+    std::vector<uint32_t> scratch;
+    std::vector<int32_t>  coverage;
+};
+
+static point2d_t white_point(float x, float y) {
+  return point2d_t{ x, y, 1.0f, 1.0f, 1.0f };
+}
+
+// Grid of cells split into two triangles each, with the inner grid points
+// moved by up to jitter cells. Below a quarter of a cell no quad folds over,
+// so the triangles tile the image without overlapping.
+static bool check_grid(const char* name,
+                       int32_t     cells,
+                       float       jitter,
+                       bool        pixel_centers,
+                       uint32_t    seed) {
+  std::mt19937                          random{ seed };
+  std::uniform_real_distribution<float> offset{ -jitter, jitter };
+
+  float cell_w = (float)IMAGE_WIDTH / cells;
+  float cell_h = (float)IMAGE_HEIGHT / cells;
+
+  std::vector<point2d_t> grid;
+
+  for(int32_t j = 0; j <= cells; j++) {
+    for(int32_t i = 0; i <= cells; i++) {
+      float x = i * cell_w;
+      float y = j * cell_h;
+
+      if(i != 0 && i != cells) {
+        x += offset(random) * cell_w;
+      }
+
+      if(j != 0 && j != cells) {
+        y += offset(random) * cell_h;
+      }
+
+      if(pixel_centers) {
+        x = i != 0 && i != cells ? std::floor(x) + 0.5f : x;
+        y = j != 0 && j != cells ? std::floor(y) + 0.5f : y;
+      }
+
+      grid.push_back(white_point(x, y));
+    }
+  }
+
+  coverage_counter counter;
+
+  for(int32_t j = 0; j < cells; j++) {
+    for(int32_t i = 0; i < cells; i++) {
+      const point2d_t& top_left     = grid[i + j * (cells + 1)];
+      const point2d_t& top_right    = grid[i + 1 + j * (cells + 1)];
+      const point2d_t& bottom_left  = grid[i + (j + 1) * (cells + 1)];
+      const point2d_t& bottom_right = grid[i + 1 + (j + 1) * (cells + 1)];
+
+      counter.draw(top_left, top_right, bottom_right);
+      counter.draw(bottom_right, bottom_left, top_left);
+    }
+  }
+
+  return counter.check(name);
+}
+
+// Fan of triangles around center, with the rim running along the image
+// border, so every edge from the center is shared by two triangles. Sorting
+// the rim by angle gives every triangle the winding draw_triangle_fixed
+// accepts.
+static bool check_fan(const char*      name,
+                      const point2d_t& center,
+                      int32_t          spokes) {
+  std::vector<point2d_t> rim;
+
+  float perimeter = 2.0f * (IMAGE_WIDTH + IMAGE_HEIGHT);
+
+  for(int32_t spoke = 0; spoke < spokes; spoke++) {
+    float distance = perimeter * spoke / spokes;
+
+    if(distance < IMAGE_WIDTH) {
+      rim.push_back(white_point(distance, 0.0f));
+      continue;
+    }
+
+    distance -= IMAGE_WIDTH;
+
+    if(distance < IMAGE_HEIGHT) {
+      rim.push_back(white_point(IMAGE_WIDTH, distance));
+      continue;
+    }
+
+    distance -= IMAGE_HEIGHT;
+
+    if(distance < IMAGE_WIDTH) {
+      rim.push_back(white_point(IMAGE_WIDTH - distance, IMAGE_HEIGHT));
+      continue;
+    }
+
+    distance -= IMAGE_WIDTH;
+    rim.push_back(white_point(0.0f, IMAGE_HEIGHT - distance));
+  }
+
+  // The corners have to be on the rim for the fan to reach them.
+  for(const point2d_t& corner : { white_point(0.0f, 0.0f),
+                                  white_point(IMAGE_WIDTH, 0.0f),
+                                  white_point(IMAGE_WIDTH, IMAGE_HEIGHT),
+                                  white_point(0.0f, IMAGE_HEIGHT) }) {
+    rim.push_back(corner);
+  }
+
+  auto angle = [&](const point2d_t& point) {
+    return std::atan2(point.y - center.y, point.x - center.x);
+  };
+
+  std::sort(rim.begin(),
+            rim.end(),
+            [&](const point2d_t& a, const point2d_t& b) {
+              return angle(a) < angle(b);
+            });
+
+  coverage_counter counter;
+
+  for(size_t index = 0; index < rim.size(); index++) {
+    counter.draw(center, rim[index], rim[(index + 1) % rim.size()]);
+  }
+
+  return counter.check(name);
+}
+
+int32_t main() {
+  bool passed = true;
+
+  for(uint32_t seed = 1; seed <= 8; seed++) {
+    passed &= check_grid("grid", 8, 0.24f, false, seed);
+    passed &= check_grid("fine grid", 32, 0.24f, false, seed);
+    passed &= check_grid("pixel-center grid", 16, 0.2f, true, seed);
+  }
+
+  passed &= check_grid("regular grid", 16, 0.0f, false, 0);
+  passed &= check_fan("fan", white_point(101.3f, 77.8f), 61);
+  passed &= check_fan("pixel-center fan", white_point(128.5f, 96.5f), 64);
+  passed &= check_fan("corner fan", white_point(0.5f, 0.5f), 40);
+  passed &= check_fan("dense fan", white_point(37.0625f, 150.9375f), 997);
+
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,60 @@
+#include "graphics/rasterizer/texture.h"
+#include "graphics/rasterizer/edge_equation.h"
+
+struct texture_shader_s {
+    const texture_t& texture;
+    int32_t          level;
+    texture_filter_e filter;
+
+    uint32_t operator()(const uv_layout_t::components_t& components) const {
+      return texture.sample(components[0], components[1], level, filter);
+    }
+};
+
+void draw_triangle_textured(uint32_t*                    image,
+                            int32_t                      image_width,
+                            int32_t                      image_height,
+                            const uv_layout_t::vertex_t& v0,
+                            const uv_layout_t::vertex_t& v1,
+                            const uv_layout_t::vertex_t& v2,
+                            const texture_t&             texture,
+                            texture_filter_e             filter) {
+  edge_equation_s e0(v1, v2);
+  edge_equation_s e1(v2, v0);
+  edge_equation_s e2(v0, v1);
+
+  float area = 0.5f * (e0.c + e1.c + e2.c);
+
+  if(area <= 0.0f) {
+    return;
+  }
+
+  // The texture coordinates are affine in screen space, so their
+  // derivatives, and with them the mip level, are constant per triangle.
+  parameter_equation_s u(v0.components[0],
+                         v1.components[0],
+                         v2.components[0],
+                         e0,
+                         e1,
+                         e2,
+                         area);
+  parameter_equation_s v(v0.components[1],
+                         v1.components[1],
+                         v2.components[1],
+                         e0,
+                         e1,
+                         e2,
+                         area);
+
+  texture_shader_s shader{ texture,
+                           texture.select_level(u.a, v.a, u.b, v.b),
+                           filter };
+
+  draw_triangle_layout<uv_layout_t>(image,
+                                    image_width,
+                                    image_height,
+                                    v0,
+                                    v1,
+                                    v2,
+                                    shader);
+}
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <cmath>
+
+#include "util.h"
+#include "graphics/rasterizer/triangle.h"
+#include "graphics/rasterizer/edge_equation.h"
+
+static constexpr int32_t TILE_SIZE = 8;
+
+static uint32_t shade_pixel(const parameter_equation_s& r,
+                            const parameter_equation_s& g,
+                            const parameter_equation_s& b,
+                            float                       x,
+                            float                       y) {
+  int32_t r_color = (int32_t)(r.evaluate(x, y) * 255);
+  int32_t g_color = (int32_t)(g.evaluate(x, y) * 255);
+  int32_t b_color = (int32_t)(b.evaluate(x, y) * 255);
+
+  return pack_color(r_color, g_color, b_color, 255);
+}
+
+void draw_triangle_trenki2_p2(uint32_t*        image,
+                              int32_t          image_width,
+                              const rect_t&    clip,
+                              const point2d_t& v0,
+                              const point2d_t& v1,
+                              const point2d_t& v2) {
+  edge_equation_s e0(v1, v2);
+  edge_equation_s e1(v2, v0);
+  edge_equation_s e2(v0, v1);
+
+  float area = 0.5f * (e0.c + e1.c + e2.c);
+
+  if(area < 0.0f) {
+    return;
+  }
+
+  parameter_equation_s r(v0.r, v1.r, v2.r, e0, e1, e2, area);
+  parameter_equation_s g(v0.g, v1.g, v2.g, e0, e1, e2, area);
+  parameter_equation_s b(v0.b, v1.b, v2.b, e0, e1, e2, area);
+
+  int32_t min_x = (int32_t)std::floor(std::min({ v0.x, v1.x, v2.x }));
+  int32_t min_y = (int32_t)std::floor(std::min({ v0.y, v1.y, v2.y }));
+  int32_t max_x = (int32_t)std::ceil(std::max({ v0.x, v1.x, v2.x }));
+  int32_t max_y = (int32_t)std::ceil(std::max({ v0.y, v1.y, v2.y }));
+
+  min_x = std::max(min_x, clip.min_x);
+  min_y = std::max(min_y, clip.min_y);
+  max_x = std::min(max_x, clip.max_x);
+  max_y = std::min(max_y, clip.max_y);
+
+  for(int32_t tile_y = min_y & ~(TILE_SIZE - 1); tile_y < max_y;
+      tile_y += TILE_SIZE) {
+    int32_t start_y = std::max(tile_y, min_y);
+    int32_t end_y   = std::min(tile_y + TILE_SIZE, max_y);
+
+    for(int32_t tile_x = min_x & ~(TILE_SIZE - 1); tile_x < max_x;
+        tile_x += TILE_SIZE) {
+      int32_t start_x = std::max(tile_x, min_x);
+      int32_t end_x   = std::min(tile_x + TILE_SIZE, max_x);
+
+      float x0 = tile_x + 0.5f;
+      float y0 = tile_y + 0.5f;
+      float x1 = tile_x + TILE_SIZE - 0.5f;
+      float y1 = tile_y + TILE_SIZE - 0.5f;
+
+      tile_coverage_e coverage = classify_tile(e0, e1, e2, x0, y0, x1, y1);
+
+      if(coverage == TILE_COVERAGE_NONE) {
+        continue;
+      }
+
+      for(int32_t y_coord = start_y; y_coord < end_y; y_coord++) {
+        float     y   = y_coord + 0.5f;
+        uint32_t* row = image + y_coord * image_width;
+
+        if(coverage == TILE_COVERAGE_FULL) {
+          for(int32_t x_coord = start_x; x_coord < end_x; x_coord++) {
+            row[x_coord] = shade_pixel(r, g, b, x_coord + 0.5f, y);
+          }
+        } else {
+          for(int32_t x_coord = start_x; x_coord < end_x; x_coord++) {
+            float x = x_coord + 0.5f;
+
+            if(e0.test(x, y) && e1.test(x, y) && e2.test(x, y)) {
+              row[x_coord] = shade_pixel(r, g, b, x, y);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+void draw_triangle_trenki2_p2(uint32_t*        image,
+                              int32_t          image_width,
+                              int32_t          image_height,
+                              const point2d_t& v0,
+                              const point2d_t& v1,
+                              const point2d_t& v2) {
+  rect_t clip{ 0, 0, image_width, image_height };
+
+  draw_triangle_trenki2_p2(image, image_width, clip, v0, v1, v2);
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+#include "util.h"
+#include "graphics/rasterizer/triangle.h"
+#include "graphics/rasterizer/edge_equation.h"
+
+// Compile-time vertex description. Every template argument is the number of
+// float components of one attribute, so vertex_layout_t<3, 2, 3> describes a
+// color, a texture coordinate and a normal packed into eight floats.
+template <size_t... component_counts>
+struct vertex_layout_t {
+    static constexpr size_t attribute_count = sizeof...(component_counts);
+    static constexpr size_t component_count = (component_counts + ... + 0);
+
+    static constexpr std::array<size_t, attribute_count> offsets = [] {
+      std::array<size_t, attribute_count> result{};
+      std::array<size_t, attribute_count> counts{ component_counts... };
+
+      size_t offset = 0;
+
+      for(size_t index = 0; index < attribute_count; index++) {
+        result[index] = offset;
+        offset += counts[index];
+      }
+
+      return result;
+    }();
+
+    using components_t = std::array<float, component_count>;
+
+    struct vertex_t {
+        float x;
+        float y;
+
+        components_t components;
+    };
+
+    template <size_t attribute>
+    static const float* get(const components_t& components) {
+      return components.data() + offsets[attribute];
+    }
+};
+
+template <typename layout_type, size_t... indices>
+std::array<parameter_equation_s, layout_type::component_count>
+make_parameter_equations(const typename layout_type::vertex_t& v0,
+                         const typename layout_type::vertex_t& v1,
+                         const typename layout_type::vertex_t& v2,
+                         const edge_equation_s&                e0,
+                         const edge_equation_s&                e1,
+                         const edge_equation_s&                e2,
+                         float                                 area,
+                         std::index_sequence<indices...>) {
+  return { parameter_equation_s(v0.components[indices],
+                                v1.components[indices],
+                                v2.components[indices],
+                                e0,
+                                e1,
+                                e2,
+                                area)... };
+}
+
+// Same tiled traversal as draw_triangle_trenki2_p2, with one parameter
+// equation per component generated from the layout. The component loop has a
+// constant trip count, so it is fully unrolled and the shader is inlined;
+// nothing is dispatched per pixel.
+template <typename layout_type, typename shader_type>
+void draw_triangle_layout(uint32_t*                             image,
+                          int32_t                               image_width,
+                          int32_t                               image_height,
+                          const typename layout_type::vertex_t& v0,
+                          const typename layout_type::vertex_t& v1,
+                          const typename layout_type::vertex_t& v2,
+                          const shader_type&                    shader) {
+  static constexpr int32_t TILE_SIZE = 8;
+  static constexpr size_t  COUNT     = layout_type::component_count;
+
+  edge_equation_s e0(v1, v2);
+  edge_equation_s e1(v2, v0);
+  edge_equation_s e2(v0, v1);
+
+  float area = 0.5f * (e0.c + e1.c + e2.c);
+
+  if(area < 0.0f) {
+    return;
+  }
+
+  std::array<parameter_equation_s, COUNT> parameters =
+      make_parameter_equations<layout_type>(v0,
+                                            v1,
+                                            v2,
+                                            e0,
+                                            e1,
+                                            e2,
+                                            area,
+                                            std::make_index_sequence<COUNT>{});
+
+  int32_t min_x = (int32_t)std::floor(std::min({ v0.x, v1.x, v2.x }));
+  int32_t min_y = (int32_t)std::floor(std::min({ v0.y, v1.y, v2.y }));
+  int32_t max_x = (int32_t)std::ceil(std::max({ v0.x, v1.x, v2.x }));
+  int32_t max_y = (int32_t)std::ceil(std::max({ v0.y, v1.y, v2.y }));
+
+  min_x = std::max(min_x, 0);
+  min_y = std::max(min_y, 0);
+  max_x = std::min(max_x, image_width);
+  max_y = std::min(max_y, image_height);
+
+  typename layout_type::components_t components;
+
+  for(int32_t tile_y = min_y & ~(TILE_SIZE - 1); tile_y < max_y;
+      tile_y += TILE_SIZE) {
+    int32_t start_y = std::max(tile_y, min_y);
+    int32_t end_y   = std::min(tile_y + TILE_SIZE, max_y);
+
+    for(int32_t tile_x = min_x & ~(TILE_SIZE - 1); tile_x < max_x;
+        tile_x += TILE_SIZE) {
+      int32_t start_x = std::max(tile_x, min_x);
+      int32_t end_x   = std::min(tile_x + TILE_SIZE, max_x);
+
+      float x0 = tile_x + 0.5f;
+      float y0 = tile_y + 0.5f;
+      float x1 = tile_x + TILE_SIZE - 0.5f;
+      float y1 = tile_y + TILE_SIZE - 0.5f;
+
+      tile_coverage_e coverage = classify_tile(e0, e1, e2, x0, y0, x1, y1);
+
+      if(coverage == TILE_COVERAGE_NONE) {
+        continue;
+      }
+
+      for(int32_t y_coord = start_y; y_coord < end_y; y_coord++) {
+        float     y   = y_coord + 0.5f;
+        uint32_t* row = image + y_coord * image_width;
+
+        for(int32_t x_coord = start_x; x_coord < end_x; x_coord++) {
+          float x = x_coord + 0.5f;
+
+          if(coverage != TILE_COVERAGE_FULL &&
+             !(e0.test(x, y) && e1.test(x, y) && e2.test(x, y))) {
+            continue;
+          }
+
+          for(size_t index = 0; index < COUNT; index++) {
+            components[index] = parameters[index].evaluate(x, y);
+          }
+
+          row[x_coord] = shader(components);
+        }
+      }
+    }
+  }
+}
+
+using rgb_layout_t = vertex_layout_t<3>;
+
+// Reproduces the hand-written r/g/b path of draw_triangle_trenki2_p2.
+struct rgb_shader_s {
+    uint32_t operator()(const rgb_layout_t::components_t& components) const {
+      return pack_color((int32_t)(components[0] * 255),
+                        (int32_t)(components[1] * 255),
+                        (int32_t)(components[2] * 255),
+                        255);
+    }
+};
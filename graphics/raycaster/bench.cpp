@@ -0,0 +1,437 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "celero/Celero.h"
+#include "celero/UserDefinedMeasurementTemplate.h"
+
+#include "graphics/raycaster/column_texture.h"
+#include "graphics/raycaster/grid_map.h"
+#include "graphics/raycaster/grid_traversal.h"
+
+CELERO_MAIN
+
+static constexpr int32_t MAP_WIDTH  = 16;
+static constexpr int32_t MAP_HEIGHT = 16;
+
+static const char BENCH_MAP[] = "0000222222220000"
+                                "1              0"
+                                "1      11111   0"
+                                "1     0        0"
+                                "0     0  1110000"
+                                "0     3        0"
+                                "0   10000      0"
+                                "0   0   11100  0"
+                                "0   0   0      0"
+                                "0   0   1  00000"
+                                "0       1      0"
+                                "2       1      0"
+                                "0       0      0"
+                                "0 0000000      0"
+                                "0              0"
+                                "0002222222200000";
+
+static constexpr size_t VIEW_COUNT   = 64;
+static constexpr size_t COLUMN_COUNT = 512;
+static constexpr float  MAX_DISTANCE = 20.0f;
+static constexpr float  FOV          = M_PI / 3.0f;
+
+class columns_per_second_udm
+  : public celero::UserDefinedMeasurementTemplate<double> {
+  public:
+    std::string getName() const override {
+      return "columns/s";
+    }
+};
+
+// Full frames of columns from random viewpoints in the open cells of the
+// raycaster's map, so both traversals see the same mix of near and far walls.
+class traversal_fixture : public celero::TestFixture {
+  public:
+    traversal_fixture()
+      : columns_per_second{ new columns_per_second_udm() } {
+      std::mt19937                          random{ 1234 };
+      std::uniform_real_distribution<float> position{ 0.0f, MAP_WIDTH };
+      std::uniform_real_distribution<float> angle{ 0.0f, 2.0f * M_PI };
+
+      while(views.size() < VIEW_COUNT) {
+        float x = position(random);
+        float y = position(random);
+
+        if(grid.at((int32_t)x, (int32_t)y) == ' ') {
+          views.push_back(view_s{ x, y, angle(random) });
+        }
+      }
+    }
+
+    std::vector<std::shared_ptr<celero::UserDefinedMeasurement>>
+    getUserDefinedMeasurements() const override {
+      return { columns_per_second };
+    }
+
+    template <typename Function>
+    void measure(Function function) {
+      auto start = std::chrono::steady_clock::now();
+
+      for(const view_s& view : views) {
+        for(size_t column = 0; column < COLUMN_COUNT; column++) {
+          float angle = view.angle - FOV / 2.0f + FOV * column / COLUMN_COUNT;
+
+          distance_sum += function(view.x, view.y, angle);
+        }
+      }
+
+      auto end = std::chrono::steady_clock::now();
+
+      std::chrono::duration<double> seconds = end - start;
+      columns_per_second->addValue(VIEW_COUNT * COLUMN_COUNT /
+                                   seconds.count());
+    }
+
+    struct view_s {
+        float x;
+        float y;
+        float angle;
+    };
+
+    grid_map_t          grid{ BENCH_MAP, MAP_WIDTH, MAP_HEIGHT };
+    std::vector<view_s> views;
+    float               distance_sum = 0.0f;
+
+    std::shared_ptr<columns_per_second_udm> columns_per_second;
+};
+
+// The fixed step march the raycaster used before cast_ray.
+BASELINE_F(traversal, march, traversal_fixture, 10, 10) {
+  measure([this](float x, float y, float angle) {
+    for(float t = 0.0f; t < MAX_DISTANCE; t += 0.01f) {
+      float cx = x + t * cos(angle);
+      float cy = y + t * sin(angle);
+
+      if(grid.at(int(cx), int(cy)) != ' ') {
+        return t;
+      }
+    }
+
+    return MAX_DISTANCE;
+  });
+  celero::DoNotOptimizeAway(distance_sum);
+}
+
+BENCHMARK_F(traversal, dda, traversal_fixture, 10, 10) {
+  measure([this](float x, float y, float angle) {
+    ray_hit_t hit;
+
+    if(!cast_ray(grid, x, y, cos(angle), sin(angle), MAX_DISTANCE, hit)) {
+      return MAX_DISTANCE;
+    }
+
+    return hit.distance;
+  });
+  celero::DoNotOptimizeAway(distance_sum);
+}
+
+// Whole views as packets, with the directions taken from a per-column angle
+// table like the raycaster does, so no sin or cos per column.
+BENCHMARK_F(traversal, packets, traversal_fixture, 10, 10) {
+  std::vector<float> offsets_cos(COLUMN_COUNT);
+  std::vector<float> offsets_sin(COLUMN_COUNT);
+  std::vector<float> directions_x(COLUMN_COUNT);
+  std::vector<float> directions_y(COLUMN_COUNT);
+  std::vector<float> distances(COLUMN_COUNT);
+  std::vector<char>  cells(COLUMN_COUNT);
+  std::vector<float> texture_u(COLUMN_COUNT);
+
+  std::vector<ray_side_e> sides(COLUMN_COUNT);
+
+  for(size_t column = 0; column < COLUMN_COUNT; column++) {
+    float offset = -FOV / 2.0f + FOV * column / COLUMN_COUNT;
+
+    offsets_cos[column] = cos(offset);
+    offsets_sin[column] = sin(offset);
+  }
+
+  ray_columns_t hits{ distances.data(),
+                      cells.data(),
+                      sides.data(),
+                      texture_u.data() };
+
+  auto start = std::chrono::steady_clock::now();
+
+  for(const view_s& view : views) {
+    float view_cos = cos(view.angle);
+    float view_sin = sin(view.angle);
+
+    for(size_t column = 0; column < COLUMN_COUNT; column++) {
+      directions_x[column] = view_cos * offsets_cos[column] -
+                             view_sin * offsets_sin[column];
+      directions_y[column] = view_sin * offsets_cos[column] +
+                             view_cos * offsets_sin[column];
+    }
+
+    cast_rays(grid,
+              view.x,
+              view.y,
+              directions_x.data(),
+              directions_y.data(),
+              COLUMN_COUNT,
+              MAX_DISTANCE,
+              hits);
+
+    for(size_t column = 0; column < COLUMN_COUNT; column++) {
+      distance_sum += cells[column] == ' ' ? MAX_DISTANCE : distances[column];
+    }
+  }
+
+  auto end = std::chrono::steady_clock::now();
+
+  std::chrono::duration<double> seconds = end - start;
+  columns_per_second->addValue(VIEW_COUNT * COLUMN_COUNT / seconds.count());
+  celero::DoNotOptimizeAway(distance_sum);
+}
+
+static constexpr int32_t LARGE_MAP_SIDE   = 4096;
+static constexpr size_t  LARGE_VIEW_COUNT = 16;
+static constexpr size_t  SEGMENT_COUNT    = 1000;
+
+// A level sized map: walls around the border and a thousand straight
+// wall segments of up to 200 cells, with long open stretches in between.
+// The same cells are kept row-major for the baseline.
+class large_map_fixture : public celero::TestFixture {
+  public:
+    large_map_fixture()
+      : row_major((size_t)LARGE_MAP_SIDE * LARGE_MAP_SIDE, ' '),
+        max_distance{ std::hypot((float)LARGE_MAP_SIDE,
+                                 (float)LARGE_MAP_SIDE) },
+        columns_per_second{ new columns_per_second_udm() } {
+      std::mt19937 random{ 1234 };
+
+      auto cell = [this](int32_t x, int32_t y) -> char& {
+        return row_major[x + (size_t)y * LARGE_MAP_SIDE];
+      };
+
+      for(int32_t i = 0; i < LARGE_MAP_SIDE; i++) {
+        cell(i, 0)                  = '1';
+        cell(i, LARGE_MAP_SIDE - 1) = '1';
+        cell(0, i)                  = '2';
+        cell(LARGE_MAP_SIDE - 1, i) = '2';
+      }
+
+      for(size_t segment = 0; segment < SEGMENT_COUNT; segment++) {
+        int32_t x      = 1 + random() % (LARGE_MAP_SIDE - 2);
+        int32_t y      = 1 + random() % (LARGE_MAP_SIDE - 2);
+        int32_t length = 4 + random() % 196;
+        bool    across = random() & 1;
+        char    color  = '0' + random() % 10;
+
+        for(int32_t i = 0; i < length; i++) {
+          int32_t at_x = across ? x + i : x;
+          int32_t at_y = across ? y : y + i;
+
+          if(at_x < LARGE_MAP_SIDE - 1 && at_y < LARGE_MAP_SIDE - 1) {
+            cell(at_x, at_y) = color;
+          }
+        }
+      }
+
+      grid = grid_map_t{ row_major.data(), LARGE_MAP_SIDE, LARGE_MAP_SIDE };
+
+      std::uniform_real_distribution<float> position{ 0.0f, LARGE_MAP_SIDE };
+      std::uniform_real_distribution<float> angle{ 0.0f, 2.0f * M_PI };
+
+      while(views.size() < LARGE_VIEW_COUNT) {
+        float x = position(random);
+        float y = position(random);
+
+        if(grid.at((int32_t)x, (int32_t)y) == ' ') {
+          views.push_back(view_s{ x, y, angle(random) });
+        }
+      }
+    }
+
+    std::vector<std::shared_ptr<celero::UserDefinedMeasurement>>
+    getUserDefinedMeasurements() const override {
+      return { columns_per_second };
+    }
+
+    template <typename Function>
+    void measure(Function function) {
+      auto start = std::chrono::steady_clock::now();
+
+      for(const view_s& view : views) {
+        for(size_t column = 0; column < COLUMN_COUNT; column++) {
+          float angle = view.angle - FOV / 2.0f + FOV * column / COLUMN_COUNT;
+
+          distance_sum += function(view.x, view.y, angle);
+        }
+      }
+
+      auto end = std::chrono::steady_clock::now();
+
+      std::chrono::duration<double> seconds = end - start;
+      columns_per_second->addValue(LARGE_VIEW_COUNT * COLUMN_COUNT /
+                                   seconds.count());
+    }
+
+    struct view_s {
+        float x;
+        float y;
+        float angle;
+    };
+
+    std::vector<char>   row_major;
+    grid_map_t          grid;
+    std::vector<view_s> views;
+    float               max_distance;
+    float               distance_sum = 0.0f;
+
+    std::shared_ptr<columns_per_second_udm> columns_per_second;
+};
+
+// Cell by cell traversal of the row-major array, without the occupancy
+// level: every cell costs a lookup, and every step along y a new cache line.
+BASELINE_F(large_map, row_major, large_map_fixture, 5, 5) {
+  measure([this](float x, float y, float angle) {
+    float direction_x = cos(angle);
+    float direction_y = sin(angle);
+    float inverse_x   = std::fabs(1.0f / direction_x);
+    float inverse_y   = std::fabs(1.0f / direction_y);
+
+    int32_t cell_x = (int32_t)x;
+    int32_t cell_y = (int32_t)y;
+    int32_t step_x = direction_x > 0.0f ? 1 : -1;
+    int32_t step_y = direction_y > 0.0f ? 1 : -1;
+
+    float next_x = (direction_x > 0.0f ? cell_x + 1.0f - x : x - cell_x) *
+                   inverse_x;
+    float next_y = (direction_y > 0.0f ? cell_y + 1.0f - y : y - cell_y) *
+                   inverse_y;
+    float distance = 0.0f;
+
+    while(distance <= max_distance && cell_x >= 0 && cell_y >= 0 &&
+          cell_x < LARGE_MAP_SIDE && cell_y < LARGE_MAP_SIDE) {
+      if(row_major[cell_x + (size_t)cell_y * LARGE_MAP_SIDE] != ' ') {
+        return distance;
+      }
+
+      if(next_x < next_y) {
+        distance = next_x;
+        next_x += inverse_x;
+        cell_x += step_x;
+      } else {
+        distance = next_y;
+        next_y += inverse_y;
+        cell_y += step_y;
+      }
+    }
+
+    return max_distance;
+  });
+  celero::DoNotOptimizeAway(distance_sum);
+}
+
+BENCHMARK_F(large_map, blocked, large_map_fixture, 5, 5) {
+  measure([this](float x, float y, float angle) {
+    ray_hit_t hit;
+
+    if(!cast_ray(grid, x, y, cos(angle), sin(angle), max_distance, hit)) {
+      return max_distance;
+    }
+
+    return hit.distance;
+  });
+  celero::DoNotOptimizeAway(distance_sum);
+}
+
+static constexpr int32_t SLICE_TEXTURE_SIZE = 256;
+static constexpr int32_t SLICE_IMAGE_WIDTH  = 512;
+static constexpr int32_t SLICE_IMAGE_HEIGHT = 512;
+
+// One screen of wall slices, each sampling a different texture column, with
+// heights from a quarter of the screen to twice the screen.
+class wall_slice_fixture : public celero::TestFixture {
+  public:
+    wall_slice_fixture()
+      : image(SLICE_IMAGE_WIDTH * SLICE_IMAGE_HEIGHT),
+        columns_per_second{ new columns_per_second_udm() } {
+      std::mt19937          random{ 1234 };
+      std::vector<uint32_t> pixels(SLICE_TEXTURE_SIZE * SLICE_TEXTURE_SIZE);
+
+      for(uint32_t& pixel : pixels) {
+        pixel = random();
+      }
+
+      row_major = pixels;
+      texture   = column_texture_t{ pixels.data(), SLICE_TEXTURE_SIZE };
+    }
+
+    std::vector<std::shared_ptr<celero::UserDefinedMeasurement>>
+    getUserDefinedMeasurements() const override {
+      return { columns_per_second };
+    }
+
+    template <typename Function>
+    void measure(Function function) {
+      auto start = std::chrono::steady_clock::now();
+
+      for(int32_t x = 0; x < SLICE_IMAGE_WIDTH; x++) {
+        int32_t height = SLICE_IMAGE_HEIGHT / 4 +
+                         x * 7 % SLICE_IMAGE_HEIGHT * 2;
+        int32_t u      = x * 37 % SLICE_TEXTURE_SIZE;
+
+        function(x, SLICE_IMAGE_HEIGHT / 2 - height / 2, height, u);
+      }
+
+      auto end = std::chrono::steady_clock::now();
+
+      std::chrono::duration<double> seconds = end - start;
+      columns_per_second->addValue(SLICE_IMAGE_WIDTH / seconds.count());
+    }
+
+    column_texture_t      texture;
+    std::vector<uint32_t> row_major;
+    std::vector<uint32_t> image;
+
+    std::shared_ptr<columns_per_second_udm> columns_per_second;
+};
+
+// The same fixed point walk down a row-major texture, one texture row apart
+// per texel.
+BASELINE_F(wall_slices, row_major, wall_slice_fixture, 10, 100) {
+  measure([this](int32_t x, int32_t y, int32_t height, int32_t u) {
+    int32_t min_y = std::max(y, 0);
+    int32_t max_y = std::min(y + height, SLICE_IMAGE_HEIGHT);
+    int64_t one   = (int64_t)SLICE_TEXTURE_SIZE << TEXTURE_FRACTION_BITS;
+
+    uint32_t step = (uint32_t)(one / height);
+    uint32_t v    = (uint32_t)(((int64_t)(min_y - y) * 2 + 1) * one /
+                            (2 * (int64_t)height));
+    uint32_t mask = SLICE_TEXTURE_SIZE - 1;
+
+    for(int32_t row = min_y; row < max_y; row++) {
+      size_t texel_y = (v >> TEXTURE_FRACTION_BITS) & mask;
+
+      image[x + (size_t)row * SLICE_IMAGE_WIDTH] =
+          row_major[u + texel_y * SLICE_TEXTURE_SIZE];
+      v += step;
+    }
+  });
+  celero::DoNotOptimizeAway(image[0]);
+}
+
+BENCHMARK_F(wall_slices, column_major, wall_slice_fixture, 10, 100) {
+  measure([this](int32_t x, int32_t y, int32_t height, int32_t u) {
+    draw_texture_span(image.data(),
+                      SLICE_IMAGE_WIDTH,
+                      SLICE_IMAGE_HEIGHT,
+                      x,
+                      y,
+                      height,
+                      texture,
+                      u);
+  });
+  celero::DoNotOptimizeAway(image[0]);
+}
@@ -0,0 +1,82 @@
+#include "graphics/raycaster/column_texture.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+static bool is_power_of_two(int32_t value) {
+  return value > 0 && (value & (value - 1)) == 0;
+}
+
+column_texture_t::column_texture_t(const uint32_t* pixels, int32_t size)
+  : size{ size }, texels((size_t)size * size) {
+  assert(is_power_of_two(size));
+
+  while((1 << shift) < size) {
+    shift++;
+  }
+
+  for(int32_t u = 0; u < size; u++) {
+    uint32_t* destination = texels.data() + ((size_t)u << shift);
+
+    for(int32_t v = 0; v < size; v++) {
+      destination[v] = pixels[u + (size_t)v * size];
+    }
+  }
+}
+
+void draw_texture_span(uint32_t*               image,
+                       int32_t                 image_stride,
+                       int32_t                 image_height,
+                       int32_t                 x,
+                       int32_t                 y,
+                       int32_t                 height,
+                       const column_texture_t& texture,
+                       int32_t                 u) {
+  if(x < 0 || x >= image_stride || height <= 0) {
+    return;
+  }
+
+  int32_t min_y = std::max(y, 0);
+  int32_t max_y = (int32_t)std::min<int64_t>((int64_t)y + height, image_height);
+
+  if(min_y >= max_y) {
+    return;
+  }
+
+  // Texels per pixel, and the coordinate at the centre of the first visible
+  // pixel. 64-bit intermediates keep very close walls from overflowing.
+  int64_t  one  = (int64_t)texture.size << TEXTURE_FRACTION_BITS;
+  uint32_t step = (uint32_t)(one / height);
+  uint32_t v    = (uint32_t)(((int64_t)(min_y - y) * 2 + 1) * one /
+                          (2 * (int64_t)height));
+
+  const uint32_t* column = texture.column(u);
+  uint32_t        mask   = (uint32_t)texture.size - 1;
+  uint32_t*       pixel  = image + (size_t)min_y * image_stride + x;
+
+  for(int32_t row = min_y; row < max_y; row++) {
+    *pixel = column[(v >> TEXTURE_FRACTION_BITS) & mask];
+    pixel += image_stride;
+    v += step;
+  }
+}
+
+void draw_texture_row(uint32_t*               row,
+                      size_t                  count,
+                      float                   origin_x,
+                      float                   origin_y,
+                      float                   distance,
+                      const float*            directions_x,
+                      const float*            directions_y,
+                      const column_texture_t& texture) {
+  float scale = (float)texture.size;
+
+  for(size_t i = 0; i < count; i++) {
+    float world_x = origin_x + distance * directions_x[i];
+    float world_y = origin_y + distance * directions_y[i];
+
+    row[i] = texture.fetch((int32_t)std::floor(world_x * scale),
+                           (int32_t)std::floor(world_y * scale));
+  }
+}
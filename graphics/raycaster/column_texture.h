@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Texture coordinates down a wall slice advance in 16.16 fixed point.
+static constexpr int32_t TEXTURE_FRACTION_BITS = 16;
+
+// Square power-of-two texture of packed pixels (see pack_color) with repeat
+// addressing, stored column-major: texel (u, v) lives at u * size + v. A wall
+// slice samples one texture column from top to bottom, so it streams through
+// consecutive texels instead of striding a whole row per screen pixel.
+struct column_texture_t {
+    int32_t               size  = 0;
+    int32_t               shift = 0;
+    std::vector<uint32_t> texels;
+
+    column_texture_t() = default;
+
+    // pixels is row-major, size x size; size must be a power of two.
+    column_texture_t(const uint32_t* pixels, int32_t size);
+
+    const uint32_t* column(int32_t u) const {
+      return texels.data() + ((size_t)(u & (size - 1)) << shift);
+    }
+
+    uint32_t fetch(int32_t u, int32_t v) const {
+      return column(u)[v & (size - 1)];
+    }
+};
+
+// Draws the one pixel wide wall slice that spans rows [y, y + height) of
+// column x, clipped to the image, stretching the texture column over it.
+// Rows of image are image_stride pixels apart, and x is clipped against that.
+// Only the visible rows are sampled; the texture coordinate starts at the
+// first of them and steps in fixed point, one addition per pixel.
+void draw_texture_span(uint32_t*               image,
+                       int32_t                 image_stride,
+                       int32_t                 image_height,
+                       int32_t                 x,
+                       int32_t                 y,
+                       int32_t                 height,
+                       const column_texture_t& texture,
+                       int32_t                 u);
+
+// Floor or ceiling row: pixel i of the count pixels at row is the texel under
+// the world position origin + distance * (directions_x[i], directions_y[i]),
+// one texture repeat per map cell.
+void draw_texture_row(uint32_t*               row,
+                      size_t                  count,
+                      float                   origin_x,
+                      float                   origin_y,
+                      float                   distance,
+                      const float*            directions_x,
+                      const float*            directions_y,
+                      const column_texture_t& texture);
@@ -0,0 +1,133 @@
+#include "graphics/raycaster/grid_map.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Keeps cell coordinates exact as floats and tile counts small.
+static constexpr int32_t MAX_MAP_SIDE = 1 << 16;
+
+grid_map_t::grid_map_t(int32_t width, int32_t height)
+  : width{ width },
+    height{ height },
+    tiles_x{ (width + MAP_TILE_SIZE - 1) >> MAP_TILE_SHIFT },
+    tiles_y{ (height + MAP_TILE_SIZE - 1) >> MAP_TILE_SHIFT },
+    cells((size_t)tiles_x * tiles_y * MAP_TILE_SIZE * MAP_TILE_SIZE, ' '),
+    occupied((size_t)tiles_x * tiles_y, 0) {}
+
+grid_map_t::grid_map_t(const char* cells, int32_t width, int32_t height)
+  : grid_map_t(width, height) {
+  for(int32_t y = 0; y < height; y++) {
+    for(int32_t x = 0; x < width; x++) {
+      set(x, y, cells[x + (size_t)y * width]);
+    }
+  }
+
+  build_occupancy();
+}
+
+void grid_map_t::build_occupancy() {
+  static constexpr size_t TILE_CELLS = MAP_TILE_SIZE * MAP_TILE_SIZE;
+
+  for(size_t tile = 0; tile < occupied.size(); tile++) {
+    const char* first = cells.data() + tile * TILE_CELLS;
+
+    occupied[tile] = std::any_of(first, first + TILE_CELLS, [](char cell) {
+      return cell != ' ';
+    });
+  }
+}
+
+// Length of the line at text, without its newline or carriage return.
+static size_t line_length(const char* text, size_t size) {
+  const char* end    = (const char*)std::memchr(text, '\n', size);
+  size_t      length = end != nullptr ? (size_t)(end - text) : size;
+
+  if(length > 0 && text[length - 1] == '\r') {
+    length--;
+  }
+
+  return length;
+}
+
+// Steps over the line at offset and its newline.
+static size_t next_line(const char* text, size_t size, size_t offset) {
+  const char* end = (const char*)std::memchr(text + offset, '\n', size - offset);
+
+  return end != nullptr ? (size_t)(end - text) + 1 : size;
+}
+
+bool load_grid_map(const char* filename, grid_map_t& map) {
+  int32_t file = open(filename, O_RDONLY);
+
+  if(file < 0) {
+    return false;
+  }
+
+  struct stat status;
+
+  if(fstat(file, &status) != 0 || status.st_size == 0) {
+    close(file);
+    return false;
+  }
+
+  size_t size    = (size_t)status.st_size;
+  void*  mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+
+  close(file);
+
+  if(mapping == MAP_FAILED) {
+    return false;
+  }
+
+  const char* text   = (const char*)mapping;
+  size_t      width  = 0;
+  size_t      height = 0;
+  bool        valid  = true;
+
+  // The first pass sizes the map and checks the characters, the second one
+  // fills it in.
+  for(size_t offset = 0; offset < size && valid;
+      offset = next_line(text, size, offset)) {
+    size_t length = line_length(text + offset, size - offset);
+
+    for(size_t index = 0; index < length && valid; index++) {
+      char cell = text[offset + index];
+
+      valid = cell == ' ' || (cell >= '0' && cell <= '9');
+    }
+
+    width = std::max(width, length);
+    height++;
+  }
+
+  valid = valid && width > 0 && width <= MAX_MAP_SIDE &&
+          height <= MAX_MAP_SIDE;
+
+  if(valid) {
+    map = grid_map_t((int32_t)width, (int32_t)height);
+
+    int32_t y = 0;
+
+    for(size_t offset = 0; offset < size;
+        offset = next_line(text, size, offset)) {
+      size_t length = line_length(text + offset, size - offset);
+
+      for(size_t x = 0; x < length; x++) {
+        map.set((int32_t)x, y, text[offset + x]);
+      }
+
+      y++;
+    }
+
+    map.build_occupancy();
+  }
+
+  munmap(mapping, size);
+
+  return valid;
+}
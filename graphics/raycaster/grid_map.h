@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Cells are grouped in square tiles of this many cells a side.
+static constexpr int32_t MAP_TILE_SHIFT = 3;
+static constexpr int32_t MAP_TILE_SIZE  = 1 << MAP_TILE_SHIFT;
+
+// Grid of map cells, one character each; ' ' is empty space and anything else
+// is a wall. The cells are stored in 8x8 tiles of 64 bytes, one cache line
+// each, with the tiles in row-major order. A ray crossing the map touches a
+// new line only when it enters another tile, whichever way it goes, where a
+// row-major grid of a large map costs a line per cell on a vertical walk.
+//
+// occupied is one coarser level on top: a byte per tile that is set when any
+// of its cells is a wall, so traversal can cross empty tiles without looking
+// at their cells.
+struct grid_map_t {
+    int32_t              width   = 0;
+    int32_t              height  = 0;
+    int32_t              tiles_x = 0;
+    int32_t              tiles_y = 0;
+    std::vector<char>    cells;
+    std::vector<uint8_t> occupied;
+
+    grid_map_t() = default;
+
+    // All cells empty.
+    grid_map_t(int32_t width, int32_t height);
+
+    // Copies row-major cells and builds the occupancy level.
+    grid_map_t(const char* cells, int32_t width, int32_t height);
+
+    size_t index(int32_t x, int32_t y) const {
+      size_t tile = (size_t)(y >> MAP_TILE_SHIFT) * tiles_x +
+                    (x >> MAP_TILE_SHIFT);
+      size_t cell = (size_t)(y & (MAP_TILE_SIZE - 1)) * MAP_TILE_SIZE +
+                    (x & (MAP_TILE_SIZE - 1));
+
+      return (tile << (2 * MAP_TILE_SHIFT)) + cell;
+    }
+
+    char at(int32_t x, int32_t y) const {
+      return cells[index(x, y)];
+    }
+
+    // Leaves the occupancy level alone; call build_occupancy once done.
+    void set(int32_t x, int32_t y, char cell) {
+      cells[index(x, y)] = cell;
+    }
+
+    bool tile_occupied(int32_t tile_x, int32_t tile_y) const {
+      return occupied[(size_t)tile_y * tiles_x + tile_x] != 0;
+    }
+
+    void build_occupancy();
+};
+
+// Loads a text map: one row of cells per line, ' ' for empty space and the
+// digits '0' to '9' for walls. The widest line sets the width and shorter
+// lines are padded with empty cells, so trailing spaces may be left out.
+// Carriage returns are ignored. Returns false when the file cannot be read,
+// is empty or holds any other character.
+bool load_grid_map(const char* filename, grid_map_t& map);
@@ -0,0 +1,553 @@
+#include "graphics/raycaster/grid_traversal.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__)
+# include <immintrin.h>
+#endif
+
+static constexpr float NO_CROSSING = std::numeric_limits<float>::infinity();
+
+// One axis of a ray. The cell coordinate along it starts at start and moves
+// by step whenever the ray crosses one of its grid lines; inverse is
+// |1 / direction|.
+struct ray_axis_s {
+    float   origin;
+    float   direction;
+    float   inverse;
+    int32_t start;
+    int32_t step;
+
+    ray_axis_s(float origin, float direction)
+      : origin{ origin },
+        direction{ direction },
+        inverse{ std::fabs(1.0f / direction) },
+        start{ (int32_t)std::floor(origin) },
+        step{ direction > 0.0f ? 1 : -1 } {}
+
+    // Ray parameter at which the ray leaves cell through its far grid line.
+    float exit(int32_t cell) const {
+      if(direction == 0.0f) {
+        return NO_CROSSING;
+      }
+
+      return direction > 0.0f ? ((float)cell + 1.0f - origin) * inverse
+                              : (origin - (float)cell) * inverse;
+    }
+
+    // Last cell of the tile holding cell, in the direction of travel.
+    int32_t tile_end(int32_t cell) const {
+      return step > 0 ? cell | (MAP_TILE_SIZE - 1)
+                      : cell & ~(MAP_TILE_SIZE - 1);
+    }
+
+    // Cell reached after taking every crossing before distance, or at it
+    // too when inclusive is set, where the answer is known to lie within
+    // [first, last] in the direction of travel. The position at distance
+    // gives a guess that is then moved to agree with exit, which keeps the
+    // result identical to stepping cell by cell.
+    int32_t cell_at(float   distance,
+                    int32_t first,
+                    int32_t last,
+                    bool    inclusive) const {
+      if(direction == 0.0f) {
+        return start;
+      }
+
+      // Cells behind the origin are never entered.
+      first = step > 0 ? std::max(first, start) : std::min(first, start);
+
+      auto crossed = [&](int32_t cell) {
+        float crossing = exit(cell);
+
+        return inclusive ? crossing <= distance : crossing < distance;
+      };
+
+      int32_t cell = (int32_t)std::floor(origin + distance * direction);
+
+      cell = step > 0 ? std::clamp(cell, first, last)
+                      : std::clamp(cell, last, first);
+
+      while(cell != last && crossed(cell)) {
+        cell += step;
+      }
+
+      while(cell != first && !crossed(cell - step)) {
+        cell -= step;
+      }
+
+      return cell;
+    }
+};
+
+// The cell walk one level up, from tile to tile, starting in the empty tile
+// holding cell and going on until the ray enters a tile with walls. Only
+// then are the cells worked out: the axis just crossed enters at its tile
+// edge, and the cell walk would have taken the other axis's crossings up to
+// and including the same distance after an x crossing, and strictly before
+// it after a y crossing. Returns false when the ray leaves the map or gets
+// further than max_distance on the way; otherwise cell, distance and side
+// are those of the cell walk entering that tile.
+static bool skip_empty_tiles(const grid_map_t& map,
+                             const ray_axis_s& axis_x,
+                             const ray_axis_s& axis_y,
+                             float             max_distance,
+                             int32_t&          cell_x,
+                             int32_t&          cell_y,
+                             float&            distance,
+                             ray_side_e&       side) {
+  int32_t last_x = axis_x.tile_end(cell_x);
+  int32_t last_y = axis_y.tile_end(cell_y);
+  float   exit_x = axis_x.exit(last_x);
+  float   exit_y = axis_y.exit(last_y);
+  int32_t tile_x;
+  int32_t tile_y;
+
+  do {
+    if(exit_x < exit_y) {
+      distance = exit_x;
+      side     = RAY_SIDE_X;
+      last_x += axis_x.step * MAP_TILE_SIZE;
+      exit_x = axis_x.exit(last_x);
+    } else {
+      distance = exit_y;
+      side     = RAY_SIDE_Y;
+      last_y += axis_y.step * MAP_TILE_SIZE;
+      exit_y = axis_y.exit(last_y);
+    }
+
+    if(distance > max_distance) {
+      return false;
+    }
+
+    tile_x = last_x >> MAP_TILE_SHIFT;
+    tile_y = last_y >> MAP_TILE_SHIFT;
+
+    if(tile_x < 0 || tile_y < 0 || tile_x >= map.tiles_x ||
+       tile_y >= map.tiles_y) {
+      return false;
+    }
+  } while(!map.tile_occupied(tile_x, tile_y));
+
+  int32_t first_x = last_x - axis_x.step * (MAP_TILE_SIZE - 1);
+  int32_t first_y = last_y - axis_y.step * (MAP_TILE_SIZE - 1);
+
+  if(side == RAY_SIDE_X) {
+    cell_x = first_x;
+    cell_y = axis_y.cell_at(distance, first_y, last_y, true);
+  } else {
+    cell_x = axis_x.cell_at(distance, first_x, last_x, false);
+    cell_y = first_y;
+  }
+
+  return true;
+}
+
+// u grows from left to right as seen along the ray, with y pointing down like
+// image rows: a ray going east sees the face's north end on its left.
+static float face_coordinate(float position, bool flip) {
+  float u = position - std::floor(position);
+
+  return flip ? 1.0f - u : u;
+}
+
+bool cast_ray(const grid_map_t& map,
+              float             origin_x,
+              float             origin_y,
+              float             direction_x,
+              float             direction_y,
+              float             max_distance,
+              ray_hit_t&        hit) {
+  ray_axis_s axis_x{ origin_x, direction_x };
+  ray_axis_s axis_y{ origin_y, direction_y };
+
+  int32_t cell_x = axis_x.start;
+  int32_t cell_y = axis_y.start;
+
+  float      distance = 0.0f;
+  ray_side_e side     = RAY_SIDE_X;
+
+  while(true) {
+    if(cell_x < 0 || cell_y < 0 || cell_x >= map.width ||
+       cell_y >= map.height) {
+      return false;
+    }
+
+    if(!map.tile_occupied(cell_x >> MAP_TILE_SHIFT, cell_y >> MAP_TILE_SHIFT)) {
+      if(!skip_empty_tiles(map,
+                           axis_x,
+                           axis_y,
+                           max_distance,
+                           cell_x,
+                           cell_y,
+                           distance,
+                           side)) {
+        return false;
+      }
+
+      continue;
+    }
+
+    char cell = map.at(cell_x, cell_y);
+
+    if(cell != ' ') {
+      hit.distance = distance;
+      hit.cell_x   = cell_x;
+      hit.cell_y   = cell_y;
+      hit.cell     = cell;
+      hit.side     = side;
+
+      if(side == RAY_SIDE_X) {
+        hit.texture_u = face_coordinate(origin_y + distance * direction_y,
+                                        direction_x < 0.0f);
+      } else {
+        hit.texture_u = face_coordinate(origin_x + distance * direction_x,
+                                        direction_y > 0.0f);
+      }
+
+      return true;
+    }
+
+    float next_x = axis_x.exit(cell_x);
+    float next_y = axis_y.exit(cell_y);
+
+    if(next_x < next_y) {
+      distance = next_x;
+      cell_x += axis_x.step;
+      side     = RAY_SIDE_X;
+    } else {
+      distance = next_y;
+      cell_y += axis_y.step;
+      side     = RAY_SIDE_Y;
+    }
+
+    if(distance > max_distance) {
+      return false;
+    }
+  }
+}
+
+static void store_miss(const ray_columns_t& hits, size_t index) {
+  hits.distances[index] = 0.0f;
+  hits.cells[index]     = ' ';
+  hits.sides[index]     = RAY_SIDE_X;
+  hits.texture_u[index] = 0.0f;
+}
+
+static void cast_rays_scalar(const grid_map_t&    map,
+                             float                origin_x,
+                             float                origin_y,
+                             const float*         directions_x,
+                             const float*         directions_y,
+                             size_t               begin,
+                             size_t               end,
+                             float                max_distance,
+                             const ray_columns_t& hits) {
+  for(size_t index = begin; index < end; index++) {
+    ray_hit_t hit;
+
+    if(!cast_ray(map,
+                 origin_x,
+                 origin_y,
+                 directions_x[index],
+                 directions_y[index],
+                 max_distance,
+                 hit)) {
+      store_miss(hits, index);
+      continue;
+    }
+
+    hits.distances[index] = hit.distance;
+    hits.cells[index]     = hit.cell;
+    hits.sides[index]     = hit.side;
+    hits.texture_u[index] = hit.texture_u;
+  }
+}
+
+// Per-lane state of a packet, spilled from the vector registers for the part
+// of each step that is done lane by lane.
+template <size_t LANES>
+struct packet_lanes_s {
+    alignas(32) int32_t cells_x[LANES];
+    alignas(32) int32_t cells_y[LANES];
+    alignas(32) float   distances[LANES];
+    alignas(32) int32_t sides[LANES];
+    alignas(32) int32_t active[LANES];
+    alignas(32) int32_t cells[LANES];
+};
+
+// The per-lane part of a packet step. Active lanes in a tile without walls
+// first skip ahead like cast_ray does, which moves their cell, distance and
+// side, or clears active when the ray runs out of map or distance on the way.
+// Every lane still active then reads its cell; the others read ' '.
+template <size_t LANES>
+static void lookup_cells(const grid_map_t&       map,
+                         float                   origin_x,
+                         float                   origin_y,
+                         const float*            directions_x,
+                         const float*            directions_y,
+                         float                   max_distance,
+                         packet_lanes_s<LANES>&  lanes) {
+  for(size_t lane = 0; lane < LANES; lane++) {
+    int32_t& x = lanes.cells_x[lane];
+    int32_t& y = lanes.cells_y[lane];
+
+    lanes.cells[lane] = ' ';
+
+    if(!lanes.active[lane]) {
+      continue;
+    }
+
+    if(!map.tile_occupied(x >> MAP_TILE_SHIFT, y >> MAP_TILE_SHIFT)) {
+      ray_side_e side = (ray_side_e)lanes.sides[lane];
+
+      bool inside = skip_empty_tiles(map,
+                                     ray_axis_s{ origin_x, directions_x[lane] },
+                                     ray_axis_s{ origin_y, directions_y[lane] },
+                                     max_distance,
+                                     x,
+                                     y,
+                                     lanes.distances[lane],
+                                     side) &&
+                    x >= 0 && y >= 0 && x < map.width && y < map.height;
+
+      lanes.sides[lane]  = side;
+      lanes.active[lane] = inside ? -1 : 0;
+
+      if(!inside) {
+        continue;
+      }
+    }
+
+    lanes.cells[lane] = map.at(x, y);
+  }
+}
+
+#if defined(__x86_64__)
+
+# define TARGET_AVX2 __attribute__((target("avx2")))
+
+// ray_axis_s for eight rays, as far as the cell by cell step needs it.
+struct ray_axis_avx2_s {
+    __m256  origin;
+    __m256  inverse;
+    __m256  positive;
+    __m256  still;
+    __m256i step;
+};
+
+TARGET_AVX2 static ray_axis_avx2_s make_axis_avx2(float  origin,
+                                                  __m256 direction) {
+  const __m256 zero = _mm256_setzero_ps();
+
+  __m256 positive = _mm256_cmp_ps(direction, zero, _CMP_GT_OQ);
+
+  // +1 where the direction is positive, -1 elsewhere.
+  __m256i step = _mm256_sub_epi32(
+      _mm256_and_si256(_mm256_castps_si256(positive), _mm256_set1_epi32(2)),
+      _mm256_set1_epi32(1));
+
+  __m256 inverse = _mm256_andnot_ps(
+      _mm256_set1_ps(-0.0f), _mm256_div_ps(_mm256_set1_ps(1.0f), direction));
+
+  return ray_axis_avx2_s{ _mm256_set1_ps(origin),
+                          inverse,
+                          positive,
+                          _mm256_cmp_ps(direction, zero, _CMP_EQ_OQ),
+                          step };
+}
+
+TARGET_AVX2 static __m256 exit_avx2(const ray_axis_avx2_s& axis,
+                                    __m256i                cell) {
+  __m256 corner = _mm256_cvtepi32_ps(cell);
+  __m256 ahead  = _mm256_mul_ps(
+      _mm256_sub_ps(_mm256_add_ps(corner, _mm256_set1_ps(1.0f)), axis.origin),
+      axis.inverse);
+  __m256 behind = _mm256_mul_ps(_mm256_sub_ps(axis.origin, corner),
+                                axis.inverse);
+
+  return _mm256_blendv_ps(_mm256_blendv_ps(behind, ahead, axis.positive),
+                          _mm256_set1_ps(NO_CROSSING),
+                          axis.still);
+}
+
+// Same steps as cast_ray, with every branch turned into a blend. Lanes past
+// count start inactive.
+TARGET_AVX2 static void cast_packet_avx2(const grid_map_t&    map,
+                                         float                origin_x,
+                                         float                origin_y,
+                                         const float*         directions_x,
+                                         const float*         directions_y,
+                                         size_t               count,
+                                         float                max_distance,
+                                         const ray_columns_t& hits) {
+  alignas(32) float   input_x[8] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+  alignas(32) float   input_y[8] = {};
+  alignas(32) int32_t indices[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+
+  for(size_t lane = 0; lane < count; lane++) {
+    input_x[lane] = directions_x[lane];
+    input_y[lane] = directions_y[lane];
+  }
+
+  const __m256  zero = _mm256_setzero_ps();
+  const __m256i none = _mm256_setzero_si256();
+  const __m256i one  = _mm256_set1_epi32(1);
+
+  __m256 direction_x = _mm256_load_ps(input_x);
+  __m256 direction_y = _mm256_load_ps(input_y);
+
+  ray_axis_avx2_s axis_x = make_axis_avx2(origin_x, direction_x);
+  ray_axis_avx2_s axis_y = make_axis_avx2(origin_y, direction_y);
+
+  __m256i cell_x = _mm256_set1_epi32((int32_t)std::floor(origin_x));
+  __m256i cell_y = _mm256_set1_epi32((int32_t)std::floor(origin_y));
+
+  const __m256i width  = _mm256_set1_epi32(map.width);
+  const __m256i height = _mm256_set1_epi32(map.height);
+  const __m256i empty  = _mm256_set1_epi32(' ');
+
+  __m256  distance = zero;
+  __m256i side     = none;
+  __m256i active   = _mm256_cmpgt_epi32(_mm256_set1_epi32((int32_t)count),
+                                        _mm256_load_si256((__m256i*)indices));
+  __m256  hit      = zero;
+  __m256  hit_dist = zero;
+  __m256i hit_cell = empty;
+  __m256i hit_side = none;
+
+  packet_lanes_s<8> lanes;
+
+  while(true) {
+    __m256i inside = _mm256_and_si256(
+        _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpgt_epi32(none, cell_x),
+                                            _mm256_cmpgt_epi32(none, cell_y)),
+                            _mm256_cmpgt_epi32(width, cell_x)),
+        _mm256_cmpgt_epi32(height, cell_y));
+
+    active = _mm256_and_si256(active, inside);
+
+    _mm256_store_si256((__m256i*)lanes.cells_x, cell_x);
+    _mm256_store_si256((__m256i*)lanes.cells_y, cell_y);
+    _mm256_store_ps(lanes.distances, distance);
+    _mm256_store_si256((__m256i*)lanes.sides, side);
+    _mm256_store_si256((__m256i*)lanes.active, active);
+    lookup_cells<8>(
+        map, origin_x, origin_y, input_x, input_y, max_distance, lanes);
+
+    cell_x   = _mm256_load_si256((__m256i*)lanes.cells_x);
+    cell_y   = _mm256_load_si256((__m256i*)lanes.cells_y);
+    distance = _mm256_load_ps(lanes.distances);
+    side     = _mm256_load_si256((__m256i*)lanes.sides);
+    active   = _mm256_load_si256((__m256i*)lanes.active);
+
+    __m256i cell = _mm256_load_si256((__m256i*)lanes.cells);
+    __m256  wall = _mm256_castsi256_ps(_mm256_andnot_si256(
+        _mm256_cmpeq_epi32(cell, empty), active));
+
+    hit      = _mm256_or_ps(hit, wall);
+    hit_dist = _mm256_blendv_ps(hit_dist, distance, wall);
+    hit_cell = _mm256_blendv_epi8(hit_cell, cell, _mm256_castps_si256(wall));
+    hit_side = _mm256_blendv_epi8(hit_side, side, _mm256_castps_si256(wall));
+    active   = _mm256_andnot_si256(_mm256_castps_si256(wall), active);
+
+    if(_mm256_testz_si256(active, active)) {
+      break;
+    }
+
+    __m256  next_x  = exit_avx2(axis_x, cell_x);
+    __m256  next_y  = exit_avx2(axis_y, cell_y);
+    __m256  along_x = _mm256_cmp_ps(next_x, next_y, _CMP_LT_OQ);
+    __m256i mask_x  = _mm256_castps_si256(along_x);
+
+    distance = _mm256_blendv_ps(next_y, next_x, along_x);
+    side     = _mm256_andnot_si256(mask_x, one);
+    cell_x = _mm256_add_epi32(cell_x, _mm256_and_si256(axis_x.step, mask_x));
+    cell_y = _mm256_add_epi32(cell_y, _mm256_andnot_si256(mask_x, axis_y.step));
+
+    __m256 beyond =
+        _mm256_cmp_ps(distance, _mm256_set1_ps(max_distance), _CMP_GT_OQ);
+
+    active = _mm256_andnot_si256(_mm256_castps_si256(beyond), active);
+  }
+
+  // Texture coordinate along the face that was hit, as in cast_ray.
+  __m256 on_x  = _mm256_castsi256_ps(_mm256_cmpeq_epi32(hit_side, none));
+  __m256 hit_x = _mm256_add_ps(_mm256_set1_ps(origin_x),
+                               _mm256_mul_ps(hit_dist, direction_x));
+  __m256 hit_y = _mm256_add_ps(_mm256_set1_ps(origin_y),
+                               _mm256_mul_ps(hit_dist, direction_y));
+
+  __m256 position = _mm256_blendv_ps(hit_x, hit_y, on_x);
+  __m256 flip = _mm256_blendv_ps(axis_y.positive,
+                                 _mm256_cmp_ps(direction_x, zero, _CMP_LT_OQ),
+                                 on_x);
+  __m256 u = _mm256_sub_ps(position, _mm256_floor_ps(position));
+
+  u = _mm256_blendv_ps(u, _mm256_sub_ps(_mm256_set1_ps(1.0f), u), flip);
+  u = _mm256_and_ps(u, hit);
+
+  alignas(32) float   out_distance[8];
+  alignas(32) float   out_u[8];
+  alignas(32) int32_t out_cell[8];
+  alignas(32) int32_t out_side[8];
+
+  _mm256_store_ps(out_distance, hit_dist);
+  _mm256_store_ps(out_u, u);
+  _mm256_store_si256((__m256i*)out_cell, hit_cell);
+  _mm256_store_si256((__m256i*)out_side, hit_side);
+
+  for(size_t lane = 0; lane < count; lane++) {
+    hits.distances[lane] = out_distance[lane];
+    hits.cells[lane]     = (char)out_cell[lane];
+    hits.sides[lane]     = out_side[lane] == 0 ? RAY_SIDE_X : RAY_SIDE_Y;
+    hits.texture_u[lane] = out_u[lane];
+  }
+}
+
+#endif
+
+void cast_rays(const grid_map_t&    map,
+               float                origin_x,
+               float                origin_y,
+               const float*         directions_x,
+               const float*         directions_y,
+               size_t               count,
+               float                max_distance,
+               const ray_columns_t& hits) {
+#if defined(__x86_64__)
+
+  if(__builtin_cpu_supports("avx2")) {
+    for(size_t index = 0; index < count; index += 8) {
+      ray_columns_t packet{ hits.distances + index,
+                            hits.cells + index,
+                            hits.sides + index,
+                            hits.texture_u + index };
+
+      cast_packet_avx2(map,
+                       origin_x,
+                       origin_y,
+                       directions_x + index,
+                       directions_y + index,
+                       std::min(count - index, (size_t)8),
+                       max_distance,
+                       packet);
+    }
+
+    return;
+  }
+
+#endif
+
+  cast_rays_scalar(map,
+                   origin_x,
+                   origin_y,
+                   directions_x,
+                   directions_y,
+                   0,
+                   count,
+                   max_distance,
+                   hits);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "graphics/raycaster/grid_map.h"
+
+enum ray_side_e {
+  // The ray entered the wall cell through a vertical grid line (x = const).
+  RAY_SIDE_X,
+  // The ray entered the wall cell through a horizontal grid line (y = const).
+  RAY_SIDE_Y,
+};
+
+struct ray_hit_t {
+    // Ray parameter of the hit point: origin + distance * direction. With a
+    // unit direction this is the Euclidean distance.
+    float      distance;
+    int32_t    cell_x;
+    int32_t    cell_y;
+    char       cell;
+    ray_side_e side;
+
+    // Position of the hit point along the wall face in [0, 1). Faces seen
+    // from the positive side are flipped, so textures never appear mirrored.
+    float texture_u;
+};
+
+// Amanatides-Woo traversal: walks the cells the ray passes through, each
+// exactly once and in order, until it enters a wall cell, leaves the map or
+// gets further than max_distance. Returns whether a wall was hit. An origin
+// inside a wall hits at distance zero.
+//
+// Grid line crossings are computed from the cell being left rather than
+// accumulated, so they depend only on the cell. That lets the walk go over
+// tiles without walls (see grid_map_t) a tile at a time, the same traversal
+// one level up, and still land on the cell and distance where it enters the
+// next tile with walls exactly as going cell by cell would.
+bool cast_ray(const grid_map_t& map,
+              float             origin_x,
+              float             origin_y,
+              float             direction_x,
+              float             direction_y,
+              float             max_distance,
+              ray_hit_t&        hit);
+
+// Structure-of-arrays results of cast_rays, one entry per ray. Rays that hit
+// nothing get distance zero, cell ' ', RAY_SIDE_X and texture_u zero.
+struct ray_columns_t {
+    float*      distances;
+    char*       cells;
+    ray_side_e* sides;
+    float*      texture_u;
+};
+
+// cast_ray for count rays from a shared origin, with the same results bit for
+// bit. With AVX2 rays advance in packets of eight lanes; lanes that have hit
+// a wall, left the map or run out of distance are masked off while the rest
+// of their packet keeps going. The map lookups and the walk over empty tiles,
+// whose length differs a lot from lane to lane, are the only per-lane work.
+// Without AVX2 the rays are cast one at a time.
+void cast_rays(const grid_map_t&    map,
+               float                origin_x,
+               float                origin_y,
+               const float*         directions_x,
+               const float*         directions_y,
+               size_t               count,
+               float                max_distance,
+               const ray_columns_t& hits);
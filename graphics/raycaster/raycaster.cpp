@@ -1,135 +1,731 @@
+#include <algorithm>
 #include <cstdint>
 #include <cmath>
+#include <cstring>
 #include <vector>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
 #include <iostream>
+#include <unordered_map>
 
 #include "util.h"
+#include "framebuffer.h"
+#include "framebuffer_fill.h"
+#include "image_writer.h"
+#include "sequence_writer.h"
+#include "async_frame_writer.h"
+#include "thread_pool.h"
+#include "graphics/raycaster/column_texture.h"
+#include "graphics/raycaster/grid_map.h"
+#include "graphics/raycaster/grid_traversal.h"
 
-void draw_rectangle(std::vector<uint32_t>& image,
-                    const size_t           img_w,
-                    const size_t           img_h,
-                    const size_t           x,
-                    const size_t           y,
-                    const size_t           w,
-                    const size_t           h,
-                    const uint32_t         color) {
-  for(size_t j = 0; j < h; j++) {
-    size_t cy = y + j;
-    if(cy >= img_h) {
+static constexpr size_t WIN_W  = 1024;
+static constexpr size_t WIN_H  = 512;
+static constexpr size_t MAP_W  = 16;
+static constexpr size_t MAP_H  = 16;
+
+static constexpr size_t COLUMN_COUNT = WIN_W / 2;
+static constexpr size_t FRAME_COUNT  = 360;
+
+// Columns per task in the column-parallel mode, a whole number of packets.
+static constexpr size_t COLUMN_CHUNK = 32;
+
+// Floor rows (each with its mirrored ceiling row) per task in the
+// column-parallel mode.
+static constexpr size_t FLOOR_CHUNK = 16;
+
+// Map rows per trace task in the column-parallel mode.
+static constexpr size_t TRACE_BAND = 32;
+
+static constexpr int32_t TEXTURE_SIZE = 64;
+
+// Keeps the wall height of a ray that grazes the player finite.
+static constexpr float MAX_WALL_HEIGHT = 1 << 24;
+
+static const char MAP[] = "0000222222220000"
+                          "1              0"
+                          "1      11111   0"
+                          "1     0        0"
+                          "0     0  1110000"
+                          "0     3        0"
+                          "0   10000      0"
+                          "0   0   11100  0"
+                          "0   0   0      0"
+                          "0   0   1  00000"
+                          "0       1      0"
+                          "2       1      0"
+                          "0       0      0"
+                          "0 0000000      0"
+                          "0              0"
+                          "0002222222200000"; // map without --map
+
+enum render_mode_e {
+  // One frame after the other, one column after the other.
+  RENDER_MODE_SERIAL,
+  // Every frame's columns, and then its map traces, are split across the pool.
+  RENDER_MODE_COLUMNS,
+  // Whole frames render concurrently, one per task, and are written in order.
+  RENDER_MODE_FRAMES,
+};
+
+// Half-open pixel rectangle of the map half, [min_x, max_x) x [min_y, max_y).
+struct dirty_rect_s {
+    int32_t min_x;
+    int32_t min_y;
+    int32_t max_x;
+    int32_t max_y;
+};
+
+static constexpr dirty_rect_s WHOLE_MAP{ 0, 0, WIN_W / 2, WIN_H };
+
+// Per-column angles relative to the view direction never change, so their
+// sines and cosines are taken once. Each frame then only rotates them by the
+// player angle, and the cosines double as the fisheye correction. Every
+// wall color has two textures, the second one shaded for faces hit through
+// a horizontal grid line. The map cells never change either; map_layer holds
+// them, drawn once, and frames copy from it instead of redrawing the map.
+// The map is scaled to fill the left half of the window, cell_width by
+// cell_height pixels per cell, which is below one pixel for large maps, and
+// rays go as far as its diagonal, max_distance.
+struct scene_s {
+    grid_map_t                    grid;
+    float                         cell_width;
+    float                         cell_height;
+    float                         max_distance;
+    std::vector<uint32_t>         colors;
+    float                         player_x;
+    float                         player_y;
+    float                         fov;
+    std::vector<float>            offsets_cos;
+    std::vector<float>            offsets_sin;
+    std::vector<column_texture_t> wall_textures;
+    column_texture_t              floor_texture;
+    column_texture_t              ceiling_texture;
+    framebuffer                   map_layer;
+};
+
+// Ray directions and hits of one frame, one entry per column. The floor
+// directions are divided by the fisheye cosine, so a floor row at
+// perpendicular distance p is at player + p * floor direction.
+struct frame_rays_s {
+    float      directions_x[COLUMN_COUNT];
+    float      directions_y[COLUMN_COUNT];
+    float      floor_x[COLUMN_COUNT];
+    float      floor_y[COLUMN_COUNT];
+    float      distances[COLUMN_COUNT];
+    char       cells[COLUMN_COUNT];
+    ray_side_e sides[COLUMN_COUNT];
+    float      texture_u[COLUMN_COUNT];
+};
+
+static void build_angle_table(scene_s& scene) {
+  scene.offsets_cos.resize(COLUMN_COUNT);
+  scene.offsets_sin.resize(COLUMN_COUNT);
+
+  for(size_t i = 0; i < COLUMN_COUNT; i++) {
+    float offset = -scene.fov / 2.0f + scene.fov * i / float(WIN_W / 2.0f);
+
+    scene.offsets_cos[i] = cos(offset);
+    scene.offsets_sin[i] = sin(offset);
+  }
+}
+
+static void aim_rays(frame_rays_s& rays, const scene_s& scene, float player_a) {
+  float view_cos = cos(player_a);
+  float view_sin = sin(player_a);
+
+  for(size_t i = 0; i < COLUMN_COUNT; i++) {
+    rays.directions_x[i] = view_cos * scene.offsets_cos[i] -
+                           view_sin * scene.offsets_sin[i];
+    rays.directions_y[i] = view_sin * scene.offsets_cos[i] +
+                           view_cos * scene.offsets_sin[i];
+    rays.floor_x[i]      = rays.directions_x[i] / scene.offsets_cos[i];
+    rays.floor_y[i]      = rays.directions_y[i] / scene.offsets_cos[i];
+  }
+}
+
+// Halves red, green and blue and keeps alpha.
+static uint32_t shade(uint32_t color) {
+  return ((color >> 1) & 0x007F7F7F) | (color & 0xFF000000);
+}
+
+// Bricks of the given color with a little per-brick variation, separated by
+// grey mortar. Appends the lit and then the shaded texture.
+static void make_brick_textures(std::vector<column_texture_t>& textures,
+                                uint32_t                       color) {
+  std::vector<uint32_t> lit(TEXTURE_SIZE * TEXTURE_SIZE);
+  std::vector<uint32_t> shaded(TEXTURE_SIZE * TEXTURE_SIZE);
+
+  uint8_t red;
+  uint8_t green;
+  uint8_t blue;
+  uint8_t alpha;
+
+  unpack_color(color, &red, &green, &blue, &alpha);
+
+  for(int32_t y = 0; y < TEXTURE_SIZE; y++) {
+    for(int32_t x = 0; x < TEXTURE_SIZE; x++) {
+      int32_t course = y / 16;
+      int32_t brick  = (x + (course & 1) * 16) / 32;
+      bool    mortar = y % 16 < 2 || (x + (course & 1) * 16) % 32 < 2;
+
+      // 75% to 100% brightness, fixed per brick.
+      int32_t light = 192 + ((course * 7 + brick * 13) & 3) * 21;
+
+      uint32_t texel =
+          mortar ? pack_color(128, 128, 128, 255)
+                 : pack_color(red * light / 255,
+                              green * light / 255,
+                              blue * light / 255,
+                              255);
+
+      lit[x + y * TEXTURE_SIZE]    = texel;
+      shaded[x + y * TEXTURE_SIZE] = shade(texel);
+    }
+  }
+
+  textures.emplace_back(lit.data(), TEXTURE_SIZE);
+  textures.emplace_back(shaded.data(), TEXTURE_SIZE);
+}
+
+// Tiles of side TEXTURE_SIZE / 2 in two alternating colors, so every map cell
+// shows a 2x2 checkerboard.
+static column_texture_t make_checker_texture(uint32_t even, uint32_t odd) {
+  std::vector<uint32_t> pixels(TEXTURE_SIZE * TEXTURE_SIZE);
+
+  for(int32_t y = 0; y < TEXTURE_SIZE; y++) {
+    for(int32_t x = 0; x < TEXTURE_SIZE; x++) {
+      bool is_odd = ((x / (TEXTURE_SIZE / 2)) ^ (y / (TEXTURE_SIZE / 2))) & 1;
+
+      pixels[x + y * TEXTURE_SIZE] = is_odd ? odd : even;
+    }
+  }
+
+  return column_texture_t{ pixels.data(), TEXTURE_SIZE };
+}
+
+// Cells [first, first + count) under pixel index along one side of the map,
+// where pixels pixels span cells cells. Every pixel gets at least one.
+static void pixel_cells(size_t   index,
+                        size_t   pixels,
+                        int32_t  cells,
+                        int32_t& first,
+                        int32_t& count) {
+  first = (int32_t)(index * cells / pixels);
+  count = std::max((int32_t)((index + 1) * cells / pixels) - first, 1);
+}
+
+// Clears image and draws the map cells on it. Every pixel takes the color of
+// the first wall among the cells it covers, so walls stay visible when the
+// map has more cells than the image has pixels. Tiles without walls are
+// passed over without looking at their cells.
+static void draw_map(framebuffer& image, const scene_s& scene) {
+  const grid_map_t& grid = scene.grid;
+
+  clear_framebuffer_view(image.view());
+
+  for(size_t y = 0; y < WIN_H; y++) {
+    int32_t min_y;
+    int32_t rows;
+
+    pixel_cells(y, WIN_H, grid.height, min_y, rows);
+
+    for(size_t x = 0; x < WIN_W / 2; x++) {
+      int32_t min_x;
+      int32_t columns;
+
+      pixel_cells(x, WIN_W / 2, grid.width, min_x, columns);
+
+      char wall = ' ';
+
+      for(int32_t j = min_y; j < min_y + rows && wall == ' '; j++) {
+        for(int32_t i = min_x; i < min_x + columns && wall == ' '; i++) {
+          if(!grid.tile_occupied(i >> MAP_TILE_SHIFT, j >> MAP_TILE_SHIFT)) {
+            i |= MAP_TILE_SIZE - 1;
+            continue;
+          }
+
+          wall = grid.at(i, j);
+        }
+      }
+
+      if(wall != ' ') {
+        image.row(y)[x] = scene.colors[wall - '0'];
+      }
+    }
+  }
+}
+
+// Casts the rays of columns [begin, end) as packets, then draws their
+// textured wall slices into the right half of the image. Every column only
+// touches its own pixels and its own entries in rays.
+static void draw_columns(framebuffer&   image,
+                         const scene_s& scene,
+                         frame_rays_s&  rays,
+                         size_t         begin,
+                         size_t         end) {
+  cast_rays(scene.grid,
+            scene.player_x,
+            scene.player_y,
+            rays.directions_x + begin,
+            rays.directions_y + begin,
+            end - begin,
+            scene.max_distance,
+            ray_columns_t{ rays.distances + begin,
+                           rays.cells + begin,
+                           rays.sides + begin,
+                           rays.texture_u + begin });
+
+  for(size_t i = begin; i < end; i++) {
+    if(rays.cells[i] == ' ') {
       continue;
     }
 
-    for(size_t i = 0; i < w; i++) {
-      size_t cx = x + i;
+    size_t icolor   = rays.cells[i] - '0';
+    float  distance = rays.distances[i] * scene.offsets_cos[i];
+
+    int32_t height = (int32_t)std::min(WIN_H / distance, MAX_WALL_HEIGHT);
+    int32_t u      = (int32_t)(rays.texture_u[i] * TEXTURE_SIZE);
+
+    draw_texture_span(image.data(),
+                      image.stride(),
+                      WIN_H,
+                      WIN_W / 2 + i,
+                      (int32_t)(WIN_H / 2) - height / 2,
+                      height,
+                      scene.wall_textures[icolor * 2 + rays.sides[i]],
+                      u);
+  }
+}
+
+// Floor rows [begin, end) below the horizon of the right half of the image,
+// counted from the horizon, and the ceiling rows mirrored above it. Walls are
+// drawn over them afterwards. The row through pixel centre y sees the floor
+// at the perpendicular distance where a wall would end at that row.
+static void draw_floor(framebuffer&        image,
+                       const scene_s&      scene,
+                       const frame_rays_s& rays,
+                       size_t              begin,
+                       size_t              end) {
+  for(size_t index = begin; index < end; index++) {
+    size_t floor_y   = WIN_H / 2 + index;
+    size_t ceiling_y = WIN_H / 2 - 1 - index;
+    float  distance  = WIN_H / (2.0f * (index + 0.5f));
+
+    draw_texture_row(image.row(floor_y) + WIN_W / 2,
+                     COLUMN_COUNT,
+                     scene.player_x,
+                     scene.player_y,
+                     distance,
+                     rays.floor_x,
+                     rays.floor_y,
+                     scene.floor_texture);
+    draw_texture_row(image.row(ceiling_y) + WIN_W / 2,
+                     COLUMN_COUNT,
+                     scene.player_x,
+                     scene.player_y,
+                     distance,
+                     rays.floor_x,
+                     rays.floor_y,
+                     scene.ceiling_texture);
+  }
+}
+
+// Rectangle that holds every pixel draw_traces writes: the rays run from the
+// player to their hits, so the box around those points with a pixel of
+// slack for rounding covers them.
+static dirty_rect_s trace_bounds(const scene_s&      scene,
+                                 const frame_rays_s& rays) {
+  float min_x = scene.player_x;
+  float min_y = scene.player_y;
+  float max_x = scene.player_x;
+  float max_y = scene.player_y;
+
+  for(size_t i = 0; i < COLUMN_COUNT; i++) {
+    float hit_x = scene.player_x + rays.distances[i] * rays.directions_x[i];
+    float hit_y = scene.player_y + rays.distances[i] * rays.directions_y[i];
+
+    min_x = std::min(min_x, hit_x);
+    min_y = std::min(min_y, hit_y);
+    max_x = std::max(max_x, hit_x);
+    max_y = std::max(max_y, hit_y);
+  }
+
+  auto pixel = [](float value, float scale, int32_t slack, int32_t limit) {
+    return std::clamp((int32_t)std::floor(value * scale) + slack, 0, limit);
+  };
+
+  return dirty_rect_s{ pixel(min_x, scene.cell_width, -1, WIN_W / 2),
+                       pixel(min_y, scene.cell_height, -1, WIN_H),
+                       pixel(max_x, scene.cell_width, 2, WIN_W / 2),
+                       pixel(max_y, scene.cell_height, 2, WIN_H) };
+}
+
+// Copies the rows of stale within [min_y, max_y) back from the map layer,
+// erasing whatever traces the framebuffer held there before.
+static void restore_map(framebuffer&        image,
+                        const scene_s&      scene,
+                        const dirty_rect_s& stale,
+                        int32_t             min_y,
+                        int32_t             max_y) {
+  int32_t first = std::max(stale.min_y, min_y);
+  int32_t last  = std::min(stale.max_y, max_y);
+  size_t  count = stale.max_x > stale.min_x ? stale.max_x - stale.min_x : 0;
+
+  for(int32_t y = first; y < last && count != 0; y++) {
+    copy_pixels(image.row(y) + stale.min_x,
+                scene.map_layer.row(y) + stale.min_x,
+                count);
+  }
+}
+
+// Traces every ray on the map, one map pixel per step, but only writes the
+// steps that land in rows [min_y, max_y). Rays overlap near the player, so
+// the column-parallel mode splits this by rows instead of by rays; step k is
+// always at t = k / cell_width, which keeps the pixels independent of the
+// split.
+static void draw_traces(framebuffer&        image,
+                        const scene_s&      scene,
+                        const frame_rays_s& rays,
+                        size_t              min_y,
+                        size_t              max_y) {
+  const uint32_t green = pack_color(0, 255, 0, 255);
+
+  float cell_width  = scene.cell_width;
+  float cell_height = scene.cell_height;
+
+  for(size_t i = 0; i < COLUMN_COUNT; i++) {
+    float direction_x = rays.directions_x[i];
+    float direction_y = rays.directions_y[i];
+    float distance    = rays.distances[i];
+
+    size_t steps = (size_t)std::ceil(distance * cell_width);
+    size_t first = 0;
+    size_t last  = steps;
 
-      if(cx >= img_w) {
-        continue;
+    // Steps whose row lies in the band, give or take one for rounding.
+    if(direction_y != 0.0f) {
+      float t0 = ((float)min_y / cell_height - scene.player_y) / direction_y;
+      float t1 = ((float)max_y / cell_height - scene.player_y) / direction_y;
+
+      float limit = (float)steps;
+      float from =
+          std::clamp(std::min(t0, t1) * cell_width - 1.0f, 0.0f, limit);
+      float to = std::clamp(std::max(t0, t1) * cell_width + 2.0f, from, limit);
+
+      first = (size_t)from;
+      last  = (size_t)to;
+    }
+
+    for(size_t k = first; k < last; k++) {
+      float t = k / cell_width;
+
+      if(t >= distance) {
+        break;
       }
 
-      image[cx + cy * img_w] = color;
+      size_t pix_x = (scene.player_x + t * direction_x) * cell_width;
+      size_t pix_y = (scene.player_y + t * direction_y) * cell_height;
+
+      if(pix_y >= min_y && pix_y < max_y) {
+        image.row(pix_y)[pix_x] = green;
+      }
     }
   }
 }
 
-int32_t main(int32_t argument_count, char** arguments) {
-  const size_t win_w  = 1024;
-  const size_t win_h  = 512;
-  const size_t map_w  = 16;
-  const size_t map_h  = 16;
-  const size_t rect_w = win_w / (map_w * 2);
-  const size_t rect_h = win_h / map_h;
-
-  const char map[] = "0000222222220000"
-                     "1              0"
-                     "1      11111   0"
-                     "1     0        0"
-                     "0     0  1110000"
-                     "0     3        0"
-                     "0   10000      0"
-                     "0   0   11100  0"
-                     "0   0   0      0"
-                     "0   0   1  00000"
-                     "0       1      0"
-                     "2       1      0"
-                     "0       0      0"
-                     "0 0000000      0"
-                     "0              0"
-                     "0002222222200000"; // our game map
-
-  float player_x = 3.456;
-  float player_y = 2.345;
-  float player_a = 1.523;
-
-  const float fov = M_PI / 3.0f;
-
-  const size_t          ncolors = 10;
-  std::vector<uint32_t> colors(ncolors);
-  for(size_t i = 0; i < ncolors; i++) {
-    colors[i] = pack_color(rand() & 255, rand() & 255, rand() & 255, 255);
-  }
-
-  for(size_t frame = 0; frame < 360; frame++) {
-    std::stringstream ss;
-    ss << std::setfill('0') << std::setw(5) << frame << ".ppm";
+// Renders one frame into image, whose map half holds the map layer except
+// inside stale (WHOLE_MAP for storage that holds nothing useful). Only stale
+// is restored before the traces go on top; the 3D half is overwritten
+// entirely. Returns the rectangle the traces of this frame dirtied.
+static dirty_rect_s render_frame(framebuffer&        image,
+                                 const scene_s&      scene,
+                                 float               player_a,
+                                 const dirty_rect_s& stale,
+                                 thread_pool*        pool) {
+  frame_rays_s rays;
 
-    player_a += 2 * M_PI / 360;
+  aim_rays(rays, scene, player_a);
 
-    std::vector<uint32_t> framebuffer(win_w * win_h, pack_color(0, 0, 0, 255));
+  if(pool == nullptr) {
+    draw_floor(image, scene, rays, 0, WIN_H / 2);
+    draw_columns(image, scene, rays, 0, COLUMN_COUNT);
+    restore_map(image, scene, stale, 0, WIN_H);
+    draw_traces(image, scene, rays, 0, WIN_H);
+    return trace_bounds(scene, rays);
+  }
 
-    for(size_t j = 0; j < map_h; j++) {
-      for(size_t i = 0; i < map_w; i++) {
-        if(map[i + j * map_w] == ' ') {
-          continue;
-        }
+  size_t floor_chunks = (WIN_H / 2 + FLOOR_CHUNK - 1) / FLOOR_CHUNK;
+
+  pool->parallel_for(floor_chunks, [&](size_t chunk) {
+    size_t begin = chunk * FLOOR_CHUNK;
+    size_t end   = std::min(begin + FLOOR_CHUNK, WIN_H / 2);
+
+    draw_floor(image, scene, rays, begin, end);
+  });
+
+  size_t chunks = (COLUMN_COUNT + COLUMN_CHUNK - 1) / COLUMN_CHUNK;
+
+  pool->parallel_for(chunks, [&](size_t chunk) {
+    size_t begin = chunk * COLUMN_CHUNK;
+    size_t end   = std::min(begin + COLUMN_CHUNK, COLUMN_COUNT);
+
+    draw_columns(image, scene, rays, begin, end);
+  });
+
+  pool->parallel_for(WIN_H / TRACE_BAND, [&](size_t band) {
+    int32_t min_y = band * TRACE_BAND;
+    int32_t max_y = (band + 1) * TRACE_BAND;
+
+    restore_map(image, scene, stale, min_y, max_y);
+    draw_traces(image, scene, rays, min_y, max_y);
+  });
+
+  return trace_bounds(scene, rays);
+}
 
-        size_t rect_x = i * rect_w;
-        size_t rect_y = j * rect_h;
-        size_t icolor = map[i + j * map_w] - '0';
-
-        draw_rectangle(framebuffer,
-                       win_w,
-                       win_h,
-                       rect_x,
-                       rect_y,
-                       rect_w,
-                       rect_h,
-                       colors[icolor]);
+// Moves the player to the centre of the first empty cell when their position
+// is off the map or inside a wall. Returns false for maps without one.
+static bool place_player(scene_s& scene) {
+  const grid_map_t& grid = scene.grid;
+
+  int32_t cell_x = (int32_t)std::floor(scene.player_x);
+  int32_t cell_y = (int32_t)std::floor(scene.player_y);
+
+  if(cell_x >= 0 && cell_y >= 0 && cell_x < grid.width &&
+     cell_y < grid.height && grid.at(cell_x, cell_y) == ' ') {
+    return true;
+  }
+
+  for(int32_t y = 0; y < grid.height; y++) {
+    for(int32_t x = 0; x < grid.width; x++) {
+      if(grid.at(x, y) == ' ') {
+        scene.player_x = x + 0.5f;
+        scene.player_y = y + 0.5f;
+        return true;
       }
     }
+  }
 
-    for(size_t i = 0; i < win_w / 2; i++) {
-      float angle = player_a - fov / 2.0f + fov * i / float(win_w / 2.0f);
-      for(float t = 0.0f; t < 20.0f; t += 0.01f) {
-        float cx = player_x + t * cos(angle);
-        float cy = player_y + t * sin(angle);
-
-        size_t pix_x = cx * rect_w;
-        size_t pix_y = cy * rect_h;
-
-        framebuffer[pix_x + pix_y * win_w] = pack_color(0, 255, 0, 255);
-
-        if(map[int(cx) + int(cy) * map_w] != ' ') {
-          size_t icolor        = map[int(cx) + int(cy) * map_w] - '0';
-          size_t column_height = win_h / (t * cos(angle - player_a));
-          draw_rectangle(framebuffer,
-                         win_w,
-                         win_h,
-                         win_w / 2 + i,
-                         win_h / 2 - column_height / 2,
-                         1,
-                         column_height,
-                         colors[icolor]);
-          break;
-        }
+  return false;
+}
+
+static void print_usage(const char* program) {
+  std::cerr << "usage: " << program << " [--mode serial|columns|frames]"
+            << " [--map map.txt]"
+            << " [stream.ppm|stream.pam|stream.y4m|stream.drle|-]"
+            << std::endl;
+}
+
+int32_t main(int32_t argument_count, char** arguments) {
+  render_mode_e mode        = RENDER_MODE_SERIAL;
+  const char*   map_name    = nullptr;
+  const char*   stream_name = nullptr;
+
+  for(int32_t index = 1; index < argument_count; index++) {
+    const char* argument  = arguments[index];
+    bool        has_value = index + 1 < argument_count;
+
+    if(std::strcmp(argument, "--mode") == 0 && has_value) {
+      const char* value = arguments[++index];
+
+      if(std::strcmp(value, "columns") == 0) {
+        mode = RENDER_MODE_COLUMNS;
+      } else if(std::strcmp(value, "frames") == 0) {
+        mode = RENDER_MODE_FRAMES;
+      } else if(std::strcmp(value, "serial") == 0) {
+        mode = RENDER_MODE_SERIAL;
+      } else {
+        print_usage(arguments[0]);
+        return 1;
       }
+    } else if(std::strcmp(argument, "--map") == 0 && has_value) {
+      map_name = arguments[++index];
+    } else if(stream_name == nullptr &&
+              (argument[0] != '-' || std::strcmp(argument, "-") == 0)) {
+      stream_name = argument;
+    } else {
+      print_usage(arguments[0]);
+      return 1;
     }
+  }
+
+  grid_map_t grid;
+
+  if(map_name == nullptr) {
+    grid = grid_map_t{ MAP, (int32_t)MAP_W, (int32_t)MAP_H };
+  } else if(!load_grid_map(map_name, grid)) {
+    std::cerr << "Cannot load map " << map_name << std::endl;
+    return 1;
+  }
+
+  float cell_width  = (float)(WIN_W / 2) / grid.width;
+  float cell_height = (float)WIN_H / grid.height;
+  float diagonal    = std::hypot((float)grid.width, (float)grid.height);
+
+  scene_s scene{ std::move(grid),
+                 cell_width,
+                 cell_height,
+                 diagonal,
+                 std::vector<uint32_t>(10),
+                 3.456f,
+                 2.345f,
+                 (float)(M_PI / 3.0f),
+                 {},
+                 {},
+                 {},
+                 {},
+                 {},
+                 framebuffer{ WIN_W / 2, WIN_H } };
+
+  if(!place_player(scene)) {
+    std::cerr << "Map " << map_name << " has no empty cell" << std::endl;
+    return 1;
+  }
+
+  build_angle_table(scene);
+
+  for(uint32_t& color : scene.colors) {
+    color = pack_color(rand() & 255, rand() & 255, rand() & 255, 255);
+    make_brick_textures(scene.wall_textures, color);
+  }
+
+  scene.floor_texture   = make_checker_texture(pack_color(96, 96, 96, 255),
+                                             pack_color(64, 64, 64, 255));
+  scene.ceiling_texture = make_checker_texture(pack_color(48, 48, 80, 255),
+                                               pack_color(40, 40, 64, 255));
+
+  draw_map(scene.map_layer, scene);
+
+  // Accumulated exactly like a frame by frame loop would, so every mode sees
+  // the same angles.
+  std::vector<float> angles(FRAME_COUNT);
+  float              player_a = 1.523;
+
+  for(size_t frame = 0; frame < FRAME_COUNT; frame++) {
+    player_a += 2 * M_PI / 360;
+    angles[frame] = player_a;
+  }
+
+  // With a filename argument all frames go into one file: a Y4M or delta-RLE
+  // sequence for .y4m and .drle (Y4M on standard output for "-"), a PAM
+  // stream for .pam and a PPM stream otherwise. Without one every frame gets
+  // its own QOI file, encoded and written in the background while the next
+  // frame renders. Write errors on either kind of stream are collected in
+  // failed and reported once all frames are out.
+  bool is_sequence = stream_name != nullptr &&
+                     (std::strcmp(stream_name, "-") == 0 ||
+                      is_sequence_filename(stream_name));
+  bool failed      = false;
+
+  image_format_e stream_format =
+      stream_name != nullptr
+          ? image_format_for_filename(stream_name, IMAGE_FORMAT_PPM)
+          : IMAGE_FORMAT_PPM;
+
+  // Concatenated QOI or PNG images are not a stream anything reads back.
+  if(!is_sequence && (stream_format == IMAGE_FORMAT_QOI ||
+                      stream_format == IMAGE_FORMAT_PNG)) {
+    std::cerr << "Cannot stream QOI or PNG to " << stream_name
+              << "; use .ppm, .pam, .y4m or .drle" << std::endl;
+    return 1;
+  }
+
+  image_writer       writer{ stream_format };
+  sequence_writer    sequence(
+      is_sequence ? sequence_format_for_filename(stream_name,
+                                                 SEQUENCE_FORMAT_Y4M)
+                  : SEQUENCE_FORMAT_Y4M);
+  async_frame_writer frames;
+  thread_pool        pool;
+
+  if(stream_name != nullptr &&
+     !(is_sequence ? sequence.open(stream_name)
+                   : writer.open_stream(stream_name))) {
+    std::cerr << "Cannot open " << stream_name << std::endl;
+    return 1;
+  }
+
+  auto output = [&](size_t frame, framebuffer image) {
+    if(is_sequence) {
+      failed |= !sequence.append(image.data(), WIN_W, WIN_H, image.stride());
+      return;
+    }
+
+    if(stream_name != nullptr) {
+      failed |= !writer.append(image.data(), WIN_W, WIN_H, image.stride());
+      return;
+    }
+
+    std::stringstream ss;
+    ss << std::setfill('0') << std::setw(5) << frame << ".qoi";
 
     std::cout << "Save frame " << ss.str() << std::endl;
 
-    write_framebuffer(ss.str().c_str(), framebuffer.data(), win_w, win_h);
+    frames.submit(ss.str(), std::move(image));
+  };
+
+  // Frames are rendered in batches of a few per worker and handed out in
+  // order, so the output does not depend on the mode.
+  size_t batch = mode == RENDER_MODE_FRAMES ? pool.size() * 2 : 1;
+
+  // Framebuffer storage cycles through the writer's pool untouched, so each
+  // block still holds the map layer plus the traces of the last frame
+  // rendered into it. Keyed by the storage, that is all a frame has to erase.
+  std::unordered_map<const uint32_t*, dirty_rect_s> traces;
+  std::vector<dirty_rect_s>                         stale;
+
+  for(size_t start = 0; start < FRAME_COUNT; start += batch) {
+    size_t                   count = std::min(batch, FRAME_COUNT - start);
+    std::vector<framebuffer> images;
+
+    stale.resize(count);
+
+    for(size_t index = 0; index < count; index++) {
+      images.push_back(frames.acquire(WIN_W, WIN_H));
+
+      auto known   = traces.find(images[index].data());
+      stale[index] = known != traces.end() ? known->second : WHOLE_MAP;
+    }
+
+    if(mode == RENDER_MODE_FRAMES) {
+      pool.parallel_for(count, [&](size_t index) {
+        stale[index] = render_frame(images[index],
+                                    scene,
+                                    angles[start + index],
+                                    stale[index],
+                                    nullptr);
+      });
+    } else {
+      stale[0] = render_frame(images[0],
+                              scene,
+                              angles[start],
+                              stale[0],
+                              mode == RENDER_MODE_COLUMNS ? &pool : nullptr);
+    }
+
+    for(size_t index = 0; index < count; index++) {
+      traces[images[index].data()] = stale[index];
+      output(start + index, std::move(images[index]));
+    }
+  }
+
+  frames.flush();
+
+  if(is_sequence && !sequence.close()) {
+    failed = true;
+  }
+
+  if(failed) {
+    std::cerr << "Cannot write " << stream_name << std::endl;
+    return 1;
+  }
+
+  if(frames.failures() != 0) {
+    std::cerr << frames.failures() << " frames could not be written"
+              << std::endl;
+    return 1;
   }
 
   return 0;
@@ -0,0 +1,650 @@
+#include "image_compress.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+#include "image_writer.h"
+#include "thread_pool.h"
+
+struct band_s {
+    std::vector<uint8_t>  bytes;
+    std::vector<uint8_t>  raw;
+    std::vector<uint32_t> row;
+    std::vector<int32_t>  table;
+    uint32_t              adler = 1;
+};
+
+// Bands, their scratch buffers and the pool are shared by every caller, so
+// only one image is encoded at a time; the pool itself does the fanning out.
+static std::mutex          encoder_mutex;
+static std::vector<band_s> encoder_bands;
+
+static thread_pool& encoder_pool() {
+  static thread_pool pool;
+
+  return pool;
+}
+
+static size_t band_count(int32_t image_height) {
+  return image_height > 0
+             ? (size_t)(image_height + IMAGE_BAND_HEIGHT - 1) /
+                   IMAGE_BAND_HEIGHT
+             : 1;
+}
+
+static void store_be32(uint8_t* destination, uint32_t value) {
+  destination[0] = (uint8_t)(value >> 24);
+  destination[1] = (uint8_t)(value >> 16);
+  destination[2] = (uint8_t)(value >> 8);
+  destination[3] = (uint8_t)(value >> 0);
+}
+
+// Appends the bands in order behind whatever output already holds.
+static void append_bands(std::vector<uint8_t>& output, size_t count) {
+  size_t total = output.size();
+
+  for(size_t index = 0; index < count; index++) {
+    total += encoder_bands[index].bytes.size();
+  }
+
+  size_t offset = output.size();
+
+  output.resize(total);
+
+  for(size_t index = 0; index < count; index++) {
+    const std::vector<uint8_t>& bytes = encoder_bands[index].bytes;
+
+    std::memcpy(output.data() + offset, bytes.data(), bytes.size());
+    offset += bytes.size();
+  }
+}
+
+static constexpr uint8_t QOI_OP_INDEX = 0x00;
+static constexpr uint8_t QOI_OP_DIFF  = 0x40;
+static constexpr uint8_t QOI_OP_LUMA  = 0x80;
+static constexpr uint8_t QOI_OP_RUN   = 0xC0;
+static constexpr uint8_t QOI_OP_RGB   = 0xFE;
+
+static constexpr int32_t QOI_MAX_RUN = 62;
+
+static void encode_qoi_band(band_s&         band,
+                            const uint32_t* image,
+                            int32_t         image_width,
+                            int32_t         image_stride,
+                            int32_t         start_y,
+                            int32_t         end_y) {
+  size_t count = (size_t)image_width * (end_y - start_y);
+
+  band.bytes.resize(count * 4 + 1);
+
+  uint8_t* output = band.bytes.data();
+
+  uint32_t index[64];
+  uint64_t seen     = 0;
+  uint32_t previous = 0xFF000000;
+  int32_t  run      = 0;
+
+  // The first band starts from the state every decoder starts from; later
+  // bands cannot know it and spell out their first pixel.
+  bool restart = start_y > 0;
+
+  for(int32_t y = start_y; y < end_y; y++) {
+    const uint32_t* row = image + (size_t)y * image_stride;
+
+    for(int32_t x = 0; x < image_width; x++) {
+      uint32_t pixel = row[x] | 0xFF000000;
+
+      if(pixel == previous && !restart) {
+        if(++run == QOI_MAX_RUN) {
+          *output++ = QOI_OP_RUN | (run - 1);
+          run       = 0;
+        }
+
+        continue;
+      }
+
+      if(run > 0) {
+        *output++ = QOI_OP_RUN | (run - 1);
+        run       = 0;
+      }
+
+      uint8_t r = (pixel >> 0) & 0xFF;
+      uint8_t g = (pixel >> 8) & 0xFF;
+      uint8_t b = (pixel >> 16) & 0xFF;
+
+      uint32_t hash = (r * 3 + g * 5 + b * 7 + 255 * 11) % 64;
+
+      if(((seen >> hash) & 1) && index[hash] == pixel) {
+        *output++ = QOI_OP_INDEX | hash;
+        previous  = pixel;
+        continue;
+      }
+
+      index[hash] = pixel;
+      seen |= (uint64_t)1 << hash;
+
+      int8_t dr = (int8_t)(r - ((previous >> 0) & 0xFF));
+      int8_t dg = (int8_t)(g - ((previous >> 8) & 0xFF));
+      int8_t db = (int8_t)(b - ((previous >> 16) & 0xFF));
+
+      int8_t dr_dg = (int8_t)(dr - dg);
+      int8_t db_dg = (int8_t)(db - dg);
+
+      if(restart) {
+        restart = false;
+      } else if(dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 &&
+                db <= 1) {
+        *output++ = QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2);
+        previous  = pixel;
+        continue;
+      } else if(dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 &&
+                db_dg >= -8 && db_dg <= 7) {
+        *output++ = QOI_OP_LUMA | (dg + 32);
+        *output++ = (dr_dg + 8) << 4 | (db_dg + 8);
+        previous  = pixel;
+        continue;
+      }
+
+      *output++ = QOI_OP_RGB;
+      *output++ = r;
+      *output++ = g;
+      *output++ = b;
+      previous  = pixel;
+    }
+  }
+
+  if(run > 0) {
+    *output++ = QOI_OP_RUN | (run - 1);
+  }
+
+  band.bytes.resize(output - band.bytes.data());
+}
+
+void encode_qoi(std::vector<uint8_t>& output,
+                const uint32_t*       image,
+                int32_t               image_width,
+                int32_t               image_height,
+                int32_t               image_stride) {
+  static constexpr uint8_t END_MARKER[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+  std::lock_guard<std::mutex> lock(encoder_mutex);
+
+  size_t count = band_count(image_height);
+
+  if(encoder_bands.size() < count) {
+    encoder_bands.resize(count);
+  }
+
+  encoder_pool().parallel_for(count, [&](size_t index) {
+    int32_t start_y = (int32_t)index * IMAGE_BAND_HEIGHT;
+    int32_t end_y   = std::min(start_y + IMAGE_BAND_HEIGHT, image_height);
+
+    encode_qoi_band(encoder_bands[index],
+                    image,
+                    image_width,
+                    image_stride,
+                    start_y,
+                    std::max(start_y, end_y));
+  });
+
+  output.resize(14);
+  std::memcpy(output.data(), "qoif", 4);
+  store_be32(output.data() + 4, (uint32_t)image_width);
+  store_be32(output.data() + 8, (uint32_t)image_height);
+  output[12] = 3;
+  output[13] = 0;
+
+  append_bands(output, count);
+  output.insert(output.end(), END_MARKER, END_MARKER + sizeof(END_MARKER));
+}
+
+static constexpr uint32_t ADLER_BASE = 65521;
+
+static uint32_t adler32(const uint8_t* data, size_t size) {
+  // Largest block whose sums cannot overflow 32 bits before the modulo.
+  static constexpr size_t BLOCK_SIZE = 5552;
+
+  uint32_t a = 1;
+  uint32_t b = 0;
+
+  while(size > 0) {
+    size_t block = std::min(size, BLOCK_SIZE);
+
+    for(size_t index = 0; index < block; index++) {
+      a += data[index];
+      b += a;
+    }
+
+    a %= ADLER_BASE;
+    b %= ADLER_BASE;
+
+    data += block;
+    size -= block;
+  }
+
+  return b << 16 | a;
+}
+
+// Checksum of the concatenation of two blocks, the second one size2 bytes
+// long, from the checksums of the blocks.
+static uint32_t adler32_combine(uint32_t adler1,
+                                uint32_t adler2,
+                                size_t   size2) {
+  uint32_t remainder = (uint32_t)(size2 % ADLER_BASE);
+  uint32_t a         = adler1 & 0xFFFF;
+  uint32_t b         = (uint32_t)((uint64_t)remainder * a % ADLER_BASE);
+
+  a += (adler2 & 0xFFFF) + ADLER_BASE - 1;
+  b += (adler1 >> 16) + (adler2 >> 16) + ADLER_BASE - remainder;
+
+  if(a >= ADLER_BASE) {
+    a -= ADLER_BASE;
+  }
+
+  if(a >= ADLER_BASE) {
+    a -= ADLER_BASE;
+  }
+
+  if(b >= ADLER_BASE * 2) {
+    b -= ADLER_BASE * 2;
+  }
+
+  if(b >= ADLER_BASE) {
+    b -= ADLER_BASE;
+  }
+
+  return b << 16 | a;
+}
+
+struct code_s {
+    uint32_t bits;
+    int32_t  length;
+};
+
+static uint32_t reverse_bits(uint32_t value, int32_t length) {
+  uint32_t result = 0;
+
+  for(int32_t bit = 0; bit < length; bit++) {
+    result = result << 1 | ((value >> bit) & 1);
+  }
+
+  return result;
+}
+
+// Fixed Huffman codes of RFC 1951 section 3.2.6, bit reversed because the
+// bit writer fills bytes from the least significant bit. Length and distance
+// entries already carry their extra bits.
+struct deflate_tables_s {
+    uint32_t crc[256];
+    code_s   literals[257];
+    code_s   lengths[259];
+    uint8_t  distance_codes[512];
+    uint16_t distance_bases[30];
+    uint8_t  distance_extra[30];
+
+    deflate_tables_s() {
+      for(uint32_t index = 0; index < 256; index++) {
+        uint32_t value = index;
+
+        for(int32_t bit = 0; bit < 8; bit++) {
+          value = value & 1 ? 0xEDB88320 ^ (value >> 1) : value >> 1;
+        }
+
+        crc[index] = value;
+      }
+
+      for(uint32_t symbol = 0; symbol < 257; symbol++) {
+        literals[symbol] = fixed_code(symbol);
+      }
+
+      static constexpr uint16_t LENGTH_BASES[29] = {
+        3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+        31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+      };
+
+      for(uint32_t code = 0; code < 29; code++) {
+        int32_t extra = code < 8 || code == 28 ? 0 : (int32_t)(code - 4) / 4;
+        int32_t last  = code == 28 ? 258 : LENGTH_BASES[code + 1] - 1;
+
+        for(int32_t length = LENGTH_BASES[code]; length <= last; length++) {
+          code_s symbol = fixed_code(257 + code);
+
+          lengths[length] = code_s{
+            symbol.bits |
+                (uint32_t)(length - LENGTH_BASES[code]) << symbol.length,
+            symbol.length + extra
+          };
+        }
+      }
+
+      uint32_t base = 1;
+
+      for(uint32_t code = 0; code < 30; code++) {
+        distance_extra[code] = code < 4 ? 0 : (uint8_t)(code / 2 - 1);
+        distance_bases[code] = (uint16_t)base;
+
+        for(uint32_t distance = base;
+            distance < base + (1u << distance_extra[code]);
+            distance++) {
+          if(distance <= 256) {
+            distance_codes[distance - 1] = (uint8_t)code;
+          } else {
+            distance_codes[256 + ((distance - 1) >> 7)] = (uint8_t)code;
+          }
+        }
+
+        base += 1u << distance_extra[code];
+      }
+    }
+
+    static code_s fixed_code(uint32_t symbol) {
+      if(symbol < 144) {
+        return code_s{ reverse_bits(0x30 + symbol, 8), 8 };
+      }
+
+      if(symbol < 256) {
+        return code_s{ reverse_bits(0x190 + symbol - 144, 9), 9 };
+      }
+
+      if(symbol < 280) {
+        return code_s{ reverse_bits(symbol - 256, 7), 7 };
+      }
+
+      return code_s{ reverse_bits(0xC0 + symbol - 280, 8), 8 };
+    }
+};
+
+static const deflate_tables_s deflate_tables;
+
+static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t size) {
+  crc = ~crc;
+
+  for(size_t index = 0; index < size; index++) {
+    crc = deflate_tables.crc[(crc ^ data[index]) & 0xFF] ^ (crc >> 8);
+  }
+
+  return ~crc;
+}
+
+struct bit_writer_s {
+    uint8_t* output;
+    uint64_t bits  = 0;
+    int32_t  count = 0;
+
+    void put(uint32_t value, int32_t length) {
+      bits |= (uint64_t)value << count;
+      count += length;
+
+      if(count >= 32) {
+        output[0] = (uint8_t)(bits >> 0);
+        output[1] = (uint8_t)(bits >> 8);
+        output[2] = (uint8_t)(bits >> 16);
+        output[3] = (uint8_t)(bits >> 24);
+        output += 4;
+        bits >>= 32;
+        count -= 32;
+      }
+    }
+
+    void put(const code_s& code) {
+      put(code.bits, code.length);
+    }
+
+    void align() {
+      for(; count > 0; count -= 8) {
+        *output++ = (uint8_t)bits;
+        bits >>= 8;
+      }
+
+      bits  = 0;
+      count = 0;
+    }
+};
+
+static constexpr int32_t HASH_BITS    = 15;
+static constexpr int32_t MIN_MATCH    = 4;
+static constexpr int32_t MAX_MATCH    = 258;
+static constexpr int32_t MAX_DISTANCE = 32768;
+
+static uint32_t load32(const uint8_t* data) {
+  uint32_t value;
+
+  std::memcpy(&value, data, sizeof(value));
+
+  return value;
+}
+
+static size_t match_length(const uint8_t* a, const uint8_t* b, size_t limit) {
+  size_t length = 0;
+
+  while(length + 8 <= limit) {
+    uint64_t x;
+    uint64_t y;
+
+    std::memcpy(&x, a + length, sizeof(x));
+    std::memcpy(&y, b + length, sizeof(y));
+
+    if(x != y) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+      return length + __builtin_ctzll(x ^ y) / 8;
+#else
+      return length + __builtin_clzll(x ^ y) / 8;
+#endif
+    }
+
+    length += 8;
+  }
+
+  while(length < limit && a[length] == b[length]) {
+    length++;
+  }
+
+  return length;
+}
+
+// One fixed Huffman block holding the whole band. Every position probes the
+// most recent earlier position with the same four byte hash, and positions
+// covered by a match are not entered into the table.
+static uint8_t* deflate_band(band_s& band, uint8_t* output, bool last) {
+  const uint8_t* data = band.raw.data();
+  size_t         size = band.raw.size();
+
+  band.table.assign((size_t)1 << HASH_BITS, -1);
+
+  bit_writer_s writer{ output };
+
+  writer.put(last ? 1 : 0, 1);
+  writer.put(1, 2);
+
+  size_t position = 0;
+
+  while(position + MIN_MATCH <= size) {
+    uint32_t hash = load32(data + position) * 2654435761u >> (32 - HASH_BITS);
+    int32_t  candidate = band.table[hash];
+
+    band.table[hash] = (int32_t)position;
+
+    size_t length = 0;
+
+    if(candidate >= 0 && position - candidate <= MAX_DISTANCE) {
+      length = match_length(data + candidate,
+                            data + position,
+                            std::min(size - position, (size_t)MAX_MATCH));
+    }
+
+    if(length < MIN_MATCH) {
+      writer.put(deflate_tables.literals[data[position]]);
+      position++;
+      continue;
+    }
+
+    uint32_t distance = (uint32_t)(position - candidate);
+    uint32_t slot     = distance <= 256 ? distance - 1
+                                        : 256 + ((distance - 1) >> 7);
+    uint32_t code     = deflate_tables.distance_codes[slot];
+
+    writer.put(deflate_tables.lengths[length]);
+    writer.put(reverse_bits(code, 5), 5);
+    writer.put(distance - deflate_tables.distance_bases[code],
+               deflate_tables.distance_extra[code]);
+
+    position += length;
+  }
+
+  for(; position < size; position++) {
+    writer.put(deflate_tables.literals[data[position]]);
+  }
+
+  writer.put(deflate_tables.literals[256]);
+
+  if(!last) {
+    // Empty stored block: pads the stream to a byte boundary so the next
+    // band can simply be appended.
+    writer.put(0, 3);
+    writer.align();
+    writer.put(0xFFFF0000, 32);
+  }
+
+  writer.align();
+
+  return writer.output;
+}
+
+static void filter_band(band_s&         band,
+                        const uint32_t* image,
+                        int32_t         image_width,
+                        int32_t         image_stride,
+                        int32_t         start_y,
+                        int32_t         end_y) {
+  static constexpr uint32_t HIGH_BITS = 0x80808080;
+
+  size_t row_size = 1 + (size_t)image_width * 3;
+
+  band.raw.resize(row_size * (end_y - start_y));
+  band.row.resize(image_width);
+
+  for(int32_t y = start_y; y < end_y; y++) {
+    const uint32_t* row    = image + (size_t)y * image_stride;
+    uint8_t*        output = band.raw.data() + row_size * (y - start_y);
+
+    // Sub filter, computed on whole pixels with a bytewise subtraction that
+    // does not borrow across channels. Dropping the alpha byte afterwards
+    // gives exactly the filtered RGB bytes.
+    uint32_t left = 0;
+
+    for(int32_t x = 0; x < image_width; x++) {
+      uint32_t pixel = row[x];
+
+      band.row[x] = ((pixel | HIGH_BITS) - (left & ~HIGH_BITS)) ^
+                    ((pixel ^ ~left) & HIGH_BITS);
+      left        = pixel;
+    }
+
+    output[0] = 1;
+    convert_rgba_to_rgb(output + 1, band.row.data(), image_width);
+  }
+}
+
+static void append_chunk(std::vector<uint8_t>& output,
+                         const char*           type,
+                         const uint8_t*        data,
+                         uint32_t              size) {
+  size_t offset = output.size();
+
+  output.resize(offset + 12 + size);
+
+  uint8_t* chunk = output.data() + offset;
+
+  store_be32(chunk, size);
+  std::memcpy(chunk + 4, type, 4);
+
+  if(size > 0) {
+    std::memcpy(chunk + 8, data, size);
+  }
+
+  store_be32(chunk + 8 + size, crc32(0, chunk + 4, size + 4));
+}
+
+void encode_png(std::vector<uint8_t>& output,
+                const uint32_t*       image,
+                int32_t               image_width,
+                int32_t               image_height,
+                int32_t               image_stride) {
+  static constexpr uint8_t SIGNATURE[8] = { 0x89, 'P',  'N',  'G',
+                                            '\r', '\n', 0x1A, '\n' };
+
+  std::lock_guard<std::mutex> lock(encoder_mutex);
+
+  size_t count = band_count(image_height);
+
+  if(encoder_bands.size() < count) {
+    encoder_bands.resize(count);
+  }
+
+  encoder_pool().parallel_for(count, [&](size_t index) {
+    band_s& band    = encoder_bands[index];
+    int32_t start_y = (int32_t)index * IMAGE_BAND_HEIGHT;
+    int32_t end_y   = std::min(start_y + IMAGE_BAND_HEIGHT, image_height);
+
+    filter_band(band,
+                image,
+                image_width,
+                image_stride,
+                start_y,
+                std::max(start_y, end_y));
+
+    band.adler = adler32(band.raw.data(), band.raw.size());
+
+    // Chunk header, zlib header, at most nine bits per literal, the end of
+    // block code, the padding block and the chunk checksum.
+    band.bytes.resize(8 + 2 + band.raw.size() * 9 / 8 + 32);
+
+    uint8_t* chunk  = band.bytes.data();
+    uint8_t* output = chunk + 8;
+
+    if(index == 0) {
+      // Deflate with a 32 KiB window, fastest compression level.
+      *output++ = 0x78;
+      *output++ = 0x01;
+    }
+
+    output = deflate_band(band, output, index + 1 == count);
+
+    uint32_t size = (uint32_t)(output - chunk - 8);
+
+    store_be32(chunk, size);
+    std::memcpy(chunk + 4, "IDAT", 4);
+    store_be32(output, crc32(0, chunk + 4, size + 4));
+
+    band.bytes.resize(12 + size);
+  });
+
+  uint8_t header[13];
+
+  store_be32(header + 0, (uint32_t)image_width);
+  store_be32(header + 4, (uint32_t)image_height);
+  header[8]  = 8;
+  header[9]  = 2;
+  header[10] = 0;
+  header[11] = 0;
+  header[12] = 0;
+
+  output.assign(SIGNATURE, SIGNATURE + sizeof(SIGNATURE));
+  append_chunk(output, "IHDR", header, sizeof(header));
+  append_bands(output, count);
+
+  uint32_t adler = encoder_bands[0].adler;
+
+  for(size_t index = 1; index < count; index++) {
+    adler = adler32_combine(adler,
+                            encoder_bands[index].adler,
+                            encoder_bands[index].raw.size());
+  }
+
+  uint8_t trailer[4];
+
+  store_be32(trailer, adler);
+  append_chunk(output, "IDAT", trailer, sizeof(trailer));
+  append_chunk(output, "IEND", nullptr, 0);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Rows per band. Bands are encoded independently and in parallel, then
+// concatenated, so the result is a single ordinary QOI or PNG file.
+static constexpr int32_t IMAGE_BAND_HEIGHT = 64;
+
+// Encodes packed pixels (see pack_color) as a 3 channel QOI image, dropping
+// the alpha channel like PPM does. Every band after the first opens with an
+// explicit QOI_OP_RGB and only indexes colors it has seen itself, so it does
+// not depend on the decoder state left behind by the bands before it.
+void encode_qoi(std::vector<uint8_t>& output,
+                const uint32_t*       image,
+                int32_t               image_width,
+                int32_t               image_height,
+                int32_t               image_stride);
+
+// Encodes packed pixels as an 8-bit RGB PNG. Rows use the Sub filter and
+// every band is compressed with a greedy single probe LZ77 into one fixed
+// Huffman deflate block, which trades some ratio for speed. Bands end on a
+// byte boundary with an empty stored block and go out as one IDAT chunk
+// each, so chunk checksums are computed in parallel as well; the per band
+// adler32 values are combined at the end.
+void encode_png(std::vector<uint8_t>& output,
+                const uint32_t*       image,
+                int32_t               image_width,
+                int32_t               image_height,
+                int32_t               image_stride);
@@ -0,0 +1,482 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "image_compress.h"
+#include "util.h"
+
+// Decodes what encode_qoi and encode_png write and checks that the RGB of
+// every pixel survives. Heights of 1, 64 and 65 rows sit on either side of a
+// band edge, and the widths leave a tail after every vector width of the RGB
+// conversion. The PNG decoder checks every chunk CRC and the adler32 of the
+// inflated data, so a wrong combined checksum fails as well. It only knows
+// the stored and fixed Huffman blocks the encoder writes.
+
+static constexpr int32_t WIDTHS[]  = { 1, 15, 16, 17, 509 };
+static constexpr int32_t HEIGHTS[] = { 1, 63, 64, 65, 130 };
+
+// Extra pixels at the end of every row, filled with a color that must not
+// show up in the output.
+static constexpr int32_t PADDING = 3;
+
+static uint32_t load_be32(const uint8_t* source) {
+  return (uint32_t)source[0] << 24 | (uint32_t)source[1] << 16 |
+         (uint32_t)source[2] << 8 | (uint32_t)source[3];
+}
+
+// Runs, gentle gradients, a small palette and noise, so every QOI operation
+// and both literals and matches in deflate show up.
+static std::vector<uint32_t> make_image(int32_t width, int32_t height) {
+  int32_t               stride = width + PADDING;
+  std::vector<uint32_t> image((size_t)stride * height);
+
+  for(int32_t y = 0; y < height; y++) {
+    for(int32_t x = 0; x < stride; x++) {
+      uint32_t hash   = ((uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u) *
+                      2654435761u;
+      uint32_t region = (uint32_t)(x / 7 + y / 5) % 4;
+      uint32_t color;
+
+      if(x >= width) {
+        color = pack_color(255, 0, 255, 0);
+      } else if(region == 0) {
+        color = pack_color(40, 80, 120, 255);
+      } else if(region == 1) {
+        color = pack_color(x, x + y, y, 255);
+      } else if(region == 2) {
+        color = pack_color((hash >> 8) % 3 * 90, 50, 200, 255);
+      } else {
+        color = pack_color(hash >> 8, hash >> 16, hash >> 24, hash);
+      }
+
+      image[x + y * stride] = color;
+    }
+  }
+
+  return image;
+}
+
+// Compares decoded RGB triples with the source image.
+static bool check_pixels(const char*                  name,
+                         const std::vector<uint8_t>&  rgb,
+                         const std::vector<uint32_t>& image,
+                         int32_t                      width,
+                         int32_t                      height) {
+  for(int32_t y = 0; y < height; y++) {
+    for(int32_t x = 0; x < width; x++) {
+      const uint8_t* pixel = rgb.data() + ((size_t)x + (size_t)y * width) * 3;
+      uint8_t        r, g, b, a;
+
+      unpack_color(image[x + y * (width + PADDING)], &r, &g, &b, &a);
+
+      if(pixel[0] != r || pixel[1] != g || pixel[2] != b) {
+        std::cerr << name << " " << width << "x" << height << ": pixel " << x
+                  << ", " << y << " differs" << std::endl;
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+static bool decode_qoi(const std::vector<uint8_t>& file,
+                       int32_t                     width,
+                       int32_t                     height,
+                       std::vector<uint8_t>&       rgb) {
+  static constexpr uint8_t END_MARKER[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+  if(file.size() < 14 + sizeof(END_MARKER) ||
+     std::memcmp(file.data(), "qoif", 4) != 0 ||
+     load_be32(file.data() + 4) != (uint32_t)width ||
+     load_be32(file.data() + 8) != (uint32_t)height || file[12] != 3) {
+    return false;
+  }
+
+  uint8_t index[64][4] = {};
+  uint8_t pixel[4]     = { 0, 0, 0, 255 };
+  size_t  position     = 14;
+  size_t  end          = file.size() - sizeof(END_MARKER);
+  size_t  count        = (size_t)width * height;
+  int32_t run          = 0;
+
+  rgb.clear();
+
+  while(rgb.size() < count * 3) {
+    if(run > 0) {
+      run--;
+    } else if(position >= end) {
+      return false;
+    } else {
+      uint8_t op = file[position++];
+
+      if(op == 0xFE || op == 0xFF) {
+        size_t channels = op == 0xFE ? 3 : 4;
+
+        if(position + channels > end) {
+          return false;
+        }
+
+        std::memcpy(pixel, file.data() + position, channels);
+        position += channels;
+      } else if((op & 0xC0) == 0x00) {
+        std::memcpy(pixel, index[op], 4);
+      } else if((op & 0xC0) == 0x40) {
+        pixel[0] += ((op >> 4) & 3) - 2;
+        pixel[1] += ((op >> 2) & 3) - 2;
+        pixel[2] += (op & 3) - 2;
+      } else if((op & 0xC0) == 0x80) {
+        if(position >= end) {
+          return false;
+        }
+
+        int32_t dg   = (op & 0x3F) - 32;
+        uint8_t next = file[position++];
+
+        pixel[0] += dg + (next >> 4) - 8;
+        pixel[1] += dg;
+        pixel[2] += dg + (next & 15) - 8;
+      } else {
+        run = op & 0x3F;
+      }
+    }
+
+    int32_t hash =
+        (pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) % 64;
+
+    std::memcpy(index[hash], pixel, 4);
+    rgb.insert(rgb.end(), pixel, pixel + 3);
+  }
+
+  return run == 0 && position == end &&
+         std::memcmp(file.data() + end, END_MARKER, sizeof(END_MARKER)) == 0;
+}
+
+class bit_reader {
+  public:
+    explicit bit_reader(const std::vector<uint8_t>& data) : data{ data } {}
+
+    // Least significant bit first, as deflate packs everything but
+    // Huffman codes.
+    uint32_t bits(int32_t count) {
+      uint32_t value = 0;
+
+      for(int32_t index = 0; index < count; index++) {
+        value |= next() << index;
+      }
+
+      return value;
+    }
+
+    // Huffman codes start with their most significant bit.
+    uint32_t code(int32_t count) {
+      uint32_t value = 0;
+
+      for(int32_t index = 0; index < count; index++) {
+        value = value << 1 | next();
+      }
+
+      return value;
+    }
+
+    void align() {
+      position = (position + 7) & ~(size_t)7;
+    }
+
+    bool failed() const {
+      return position > data.size() * 8;
+    }
+
+    size_t byte_position() const {
+      return position / 8;
+    }
+
+  private:
+    uint32_t next() {
+      size_t byte = position / 8;
+      size_t bit  = position % 8;
+
+      position++;
+      return byte < data.size() ? (data[byte] >> bit) & 1 : 0;
+    }
+
+    const std::vector<uint8_t>& data;
+    size_t                      position = 0;
+};
+
+// Literal or length symbol of the fixed Huffman code.
+static int32_t fixed_literal(bit_reader& input) {
+  uint32_t value = input.code(7);
+
+  if(value <= 0x17) {
+    return 256 + value;
+  }
+
+  value = value << 1 | input.code(1);
+
+  if(value >= 0x30 && value <= 0xBF) {
+    return value - 0x30;
+  }
+
+  if(value >= 0xC0 && value <= 0xC7) {
+    return 280 + value - 0xC0;
+  }
+
+  return 144 + (value << 1 | input.code(1)) - 0x190;
+}
+
+static bool inflate(const std::vector<uint8_t>& stream,
+                    std::vector<uint8_t>&       output) {
+  static constexpr uint16_t LENGTH_BASE[29] = {
+    3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+    31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+  };
+  static constexpr uint8_t  LENGTH_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+    2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+  };
+  static constexpr uint16_t DISTANCE_BASE[30] = {
+    1,    2,    3,    4,    5,    7,     9,     13,    17,    25,
+    33,   49,   65,   97,   129,  193,   257,   385,   513,   769,
+    1025, 1537, 2049, 3073, 4097, 6145,  8193,  12289, 16385, 24577,
+  };
+  static constexpr uint8_t  DISTANCE_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+    6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+  };
+
+  bit_reader input{ stream };
+
+  // zlib header: deflate with a window of at most 32 KiB, no dictionary.
+  uint32_t method = input.bits(8);
+  uint32_t flags  = input.bits(8);
+
+  if((method & 15) != 8 || (method >> 4) > 7 || (flags & 0x20) != 0 ||
+     (method << 8 | flags) % 31 != 0) {
+    return false;
+  }
+
+  bool last = false;
+
+  while(!last) {
+    last          = input.bits(1) != 0;
+    uint32_t type = input.bits(2);
+
+    if(type == 0) {
+      input.align();
+
+      uint32_t length  = input.bits(16);
+      uint32_t inverse = input.bits(16);
+      size_t   start   = input.byte_position();
+
+      if((length ^ 0xFFFF) != inverse || start + length > stream.size()) {
+        return false;
+      }
+
+      output.insert(output.end(),
+                    stream.begin() + start,
+                    stream.begin() + start + length);
+      input.bits(length * 8);
+      continue;
+    }
+
+    if(type != 1) {
+      return false;
+    }
+
+    while(true) {
+      int32_t symbol = fixed_literal(input);
+
+      if(input.failed() || symbol > 285) {
+        return false;
+      }
+
+      if(symbol < 256) {
+        output.push_back((uint8_t)symbol);
+        continue;
+      }
+
+      if(symbol == 256) {
+        break;
+      }
+
+      symbol -= 257;
+
+      uint32_t length = LENGTH_BASE[symbol] + input.bits(LENGTH_EXTRA[symbol]);
+      uint32_t code   = input.code(5);
+
+      if(code >= 30) {
+        return false;
+      }
+
+      uint32_t distance =
+          DISTANCE_BASE[code] + input.bits(DISTANCE_EXTRA[code]);
+
+      if(distance > output.size()) {
+        return false;
+      }
+
+      for(uint32_t index = 0; index < length; index++) {
+        output.push_back(output[output.size() - distance]);
+      }
+    }
+  }
+
+  input.align();
+
+  if(input.failed() || input.byte_position() + 4 != stream.size()) {
+    return false;
+  }
+
+  uint32_t a = 1;
+  uint32_t b = 0;
+
+  for(uint8_t byte : output) {
+    a = (a + byte) % 65521;
+    b = (b + a) % 65521;
+  }
+
+  return load_be32(stream.data() + input.byte_position()) == (b << 16 | a);
+}
+
+static uint32_t crc32(const uint8_t* data, size_t size) {
+  uint32_t crc = 0xFFFFFFFF;
+
+  for(size_t index = 0; index < size; index++) {
+    crc ^= data[index];
+
+    for(int32_t bit = 0; bit < 8; bit++) {
+      crc = crc >> 1 ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+
+  return crc ^ 0xFFFFFFFF;
+}
+
+static uint8_t paeth(uint8_t left, uint8_t up, uint8_t up_left) {
+  int32_t estimate = left + up - up_left;
+  int32_t to_left  = std::abs(estimate - left);
+  int32_t to_up    = std::abs(estimate - up);
+  int32_t to_ul    = std::abs(estimate - up_left);
+
+  if(to_left <= to_up && to_left <= to_ul) {
+    return left;
+  }
+
+  return to_up <= to_ul ? up : up_left;
+}
+
+static bool decode_png(const std::vector<uint8_t>& file,
+                       int32_t                     width,
+                       int32_t                     height,
+                       std::vector<uint8_t>&       rgb) {
+  static constexpr uint8_t SIGNATURE[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+  if(file.size() < 8 || std::memcmp(file.data(), SIGNATURE, 8) != 0) {
+    return false;
+  }
+
+  std::vector<uint8_t> stream;
+  size_t               position = 8;
+  bool                 header   = false;
+  bool                 end      = false;
+
+  while(!end) {
+    if(position + 12 > file.size()) {
+      return false;
+    }
+
+    uint32_t       length = load_be32(file.data() + position);
+    const uint8_t* type   = file.data() + position + 4;
+    const uint8_t* data   = type + 4;
+
+    if(position + 12 + length > file.size() ||
+       crc32(type, length + 4) != load_be32(data + length)) {
+      return false;
+    }
+
+    if(std::memcmp(type, "IHDR", 4) == 0) {
+      static constexpr uint8_t RGB8[5] = { 8, 2, 0, 0, 0 };
+
+      header = length == 13 && load_be32(data) == (uint32_t)width &&
+               load_be32(data + 4) == (uint32_t)height &&
+               std::memcmp(data + 8, RGB8, 5) == 0;
+    } else if(std::memcmp(type, "IDAT", 4) == 0) {
+      stream.insert(stream.end(), data, data + length);
+    } else if(std::memcmp(type, "IEND", 4) == 0) {
+      end = true;
+    }
+
+    position += 12 + length;
+  }
+
+  std::vector<uint8_t> raw;
+  size_t               row_size = (size_t)width * 3;
+
+  if(!header || position != file.size() || !inflate(stream, raw) ||
+     raw.size() != (row_size + 1) * height) {
+    return false;
+  }
+
+  rgb.assign(row_size * height, 0);
+
+  for(int32_t y = 0; y < height; y++) {
+    const uint8_t* source = raw.data() + (row_size + 1) * y;
+    uint8_t*       row    = rgb.data() + row_size * y;
+    const uint8_t* above  = y > 0 ? row - row_size : nullptr;
+
+    for(size_t index = 0; index < row_size; index++) {
+      uint8_t left    = index >= 3 ? row[index - 3] : 0;
+      uint8_t up      = above != nullptr ? above[index] : 0;
+      uint8_t up_left = above != nullptr && index >= 3 ? above[index - 3] : 0;
+      uint8_t value   = source[1 + index];
+
+      switch(source[0]) {
+        case 0: row[index] = value; break;
+        case 1: row[index] = value + left; break;
+        case 2: row[index] = value + up; break;
+        case 3: row[index] = value + (left + up) / 2; break;
+        case 4: row[index] = value + paeth(left, up, up_left); break;
+        default: return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+int32_t main() {
+  size_t errors = 0;
+
+  for(int32_t width : WIDTHS) {
+    for(int32_t height : HEIGHTS) {
+      std::vector<uint32_t> image = make_image(width, height);
+      std::vector<uint8_t>  file;
+      std::vector<uint8_t>  rgb;
+
+      encode_qoi(file, image.data(), width, height, width + PADDING);
+
+      if(!decode_qoi(file, width, height, rgb)) {
+        std::cerr << "qoi " << width << "x" << height << ": cannot decode"
+                  << std::endl;
+        errors++;
+      } else if(!check_pixels("qoi", rgb, image, width, height)) {
+        errors++;
+      }
+
+      encode_png(file, image.data(), width, height, width + PADDING);
+
+      if(!decode_png(file, width, height, rgb)) {
+        std::cerr << "png " << width << "x" << height << ": cannot decode"
+                  << std::endl;
+        errors++;
+      } else if(!check_pixels("png", rgb, image, width, height)) {
+        errors++;
+      }
+    }
+  }
+
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,547 @@
+#include "image_diff.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__)
+# include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+#endif
+
+image_reader::~image_reader() {
+  close();
+}
+
+bool image_reader::open(const char* filename) {
+  close();
+
+  int32_t file = ::open(filename, O_RDONLY);
+
+  if(file < 0) {
+    error = true;
+    return false;
+  }
+
+  struct stat status;
+
+  if(fstat(file, &status) != 0) {
+    ::close(file);
+    error = true;
+    return false;
+  }
+
+  size = (size_t)status.st_size;
+
+  if(size > 0) {
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+
+    if(mapping == MAP_FAILED) {
+      ::close(file);
+      size  = 0;
+      error = true;
+      return false;
+    }
+
+    data = (const uint8_t*)mapping;
+    madvise(mapping, size, MADV_SEQUENTIAL);
+  }
+
+  ::close(file);
+
+  return true;
+}
+
+void image_reader::close() {
+  if(data != nullptr) {
+    munmap((void*)data, size);
+  }
+
+  data   = nullptr;
+  size   = 0;
+  offset = 0;
+  error  = false;
+}
+
+bool image_reader::failed() const {
+  return error;
+}
+
+static bool is_space(uint8_t character) {
+  return character == ' ' || character == '\t' || character == '\n' ||
+         character == '\r';
+}
+
+// Reads one whitespace separated token, skipping '#' comments.
+static bool read_token(const uint8_t* data,
+                       size_t         size,
+                       size_t&        offset,
+                       char*          token,
+                       size_t         token_size) {
+  while(offset < size) {
+    if(data[offset] == '#') {
+      while(offset < size && data[offset] != '\n') {
+        offset++;
+      }
+    } else if(is_space(data[offset])) {
+      offset++;
+    } else {
+      break;
+    }
+  }
+
+  size_t length = 0;
+
+  while(offset < size && !is_space(data[offset]) &&
+        length + 1 < token_size) {
+    token[length++] = (char)data[offset++];
+  }
+
+  token[length] = '\0';
+
+  return length > 0 && (offset == size || is_space(data[offset]));
+}
+
+static bool read_number(const uint8_t* data,
+                        size_t         size,
+                        size_t&        offset,
+                        int32_t&       value) {
+  char token[16];
+
+  if(!read_token(data, size, offset, token, sizeof(token))) {
+    return false;
+  }
+
+  char* end    = nullptr;
+  long  number = std::strtol(token, &end, 10);
+
+  if(*end != '\0' || number <= 0 || number > (1 << 16)) {
+    return false;
+  }
+
+  value = (int32_t)number;
+
+  return true;
+}
+
+bool image_reader::read(framebuffer& image) {
+  if(error || offset >= size) {
+    return false;
+  }
+
+  // Nothing but whitespace after the last image is a clean end.
+  size_t rest = offset;
+
+  while(rest < size && is_space(data[rest])) {
+    rest++;
+  }
+
+  if(rest == size) {
+    offset = size;
+    return false;
+  }
+
+  char    token[32];
+  int32_t width  = 0;
+  int32_t height = 0;
+  int32_t depth  = 3;
+  int32_t maxval = 0;
+  bool    valid  = read_token(data, size, offset, token, sizeof(token));
+  bool    is_pam = valid && std::strcmp(token, "P7") == 0;
+
+  if(valid && std::strcmp(token, "P6") == 0) {
+    valid = read_number(data, size, offset, width) &&
+            read_number(data, size, offset, height) &&
+            read_number(data, size, offset, maxval);
+  } else if(is_pam) {
+    while(valid) {
+      valid = read_token(data, size, offset, token, sizeof(token));
+
+      if(!valid || std::strcmp(token, "ENDHDR") == 0) {
+        break;
+      }
+
+      if(std::strcmp(token, "WIDTH") == 0) {
+        valid = read_number(data, size, offset, width);
+      } else if(std::strcmp(token, "HEIGHT") == 0) {
+        valid = read_number(data, size, offset, height);
+      } else if(std::strcmp(token, "DEPTH") == 0) {
+        valid = read_number(data, size, offset, depth);
+      } else if(std::strcmp(token, "MAXVAL") == 0) {
+        valid = read_number(data, size, offset, maxval);
+      } else if(std::strcmp(token, "TUPLTYPE") == 0) {
+        valid = read_token(data, size, offset, token, sizeof(token));
+      } else {
+        valid = false;
+      }
+    }
+  } else {
+    valid = false;
+  }
+
+  // Exactly one whitespace character separates the header from the pixels.
+  valid = valid && width > 0 && height > 0 && maxval == 255 &&
+          (depth == 3 || depth == 4) && offset < size;
+
+  size_t row_size = (size_t)width * depth;
+
+  if(!valid || size - offset - 1 < row_size * height) {
+    error = true;
+    return false;
+  }
+
+  offset++;
+
+  if(image.width() != width || image.height() != height) {
+    image = framebuffer(width, height);
+  }
+
+  for(int32_t y = 0; y < height; y++) {
+    const uint8_t* input  = data + offset + row_size * y;
+    uint32_t*      output = image.row(y);
+
+    for(int32_t x = 0; x < width; x++) {
+      const uint8_t* pixel = input + (size_t)x * depth;
+
+      output[x] = pack_color(pixel[0],
+                             pixel[1],
+                             pixel[2],
+                             depth == 4 ? pixel[3] : 255);
+    }
+  }
+
+  offset += row_size * height;
+
+  return true;
+}
+
+#if defined(__x86_64__)
+
+# define TARGET_AVX2 __attribute__((target("avx2")))
+
+static size_t count_different_sse2(const uint32_t* a,
+                                   const uint32_t* b,
+                                   size_t          count,
+                                   size_t&         different) {
+  size_t index = 0;
+
+  for(; index + 4 <= count; index += 4) {
+    __m128i x     = _mm_loadu_si128((const __m128i*)(a + index));
+    __m128i y     = _mm_loadu_si128((const __m128i*)(b + index));
+    __m128i equal = _mm_cmpeq_epi32(x, y);
+
+    different +=
+        4 - __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(equal)));
+  }
+
+  return index;
+}
+
+TARGET_AVX2 static size_t count_different_avx2(const uint32_t* a,
+                                               const uint32_t* b,
+                                               size_t          count,
+                                               size_t&         different) {
+  size_t index = 0;
+
+  for(; index + 8 <= count; index += 8) {
+    __m256i x     = _mm256_loadu_si256((const __m256i*)(a + index));
+    __m256i y     = _mm256_loadu_si256((const __m256i*)(b + index));
+    __m256i equal = _mm256_cmpeq_epi32(x, y);
+
+    different +=
+        8 - __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(equal)));
+  }
+
+  return index;
+}
+
+// Absolute differences of all bytes via two saturating subtractions; a pixel
+// is over the tolerance when any of its bytes is still non-zero after taking
+// the tolerance off once more.
+static size_t compare_tolerance_sse2(const uint32_t* a,
+                                     const uint32_t* b,
+                                     size_t          count,
+                                     uint8_t         tolerance,
+                                     size_t&         different,
+                                     uint8_t&        max_channel) {
+  const __m128i limit = _mm_set1_epi8((char)tolerance);
+  const __m128i zero  = _mm_setzero_si128();
+
+  __m128i maximum = _mm_setzero_si128();
+  size_t  index   = 0;
+
+  for(; index + 4 <= count; index += 4) {
+    __m128i x = _mm_loadu_si128((const __m128i*)(a + index));
+    __m128i y = _mm_loadu_si128((const __m128i*)(b + index));
+    __m128i d = _mm_or_si128(_mm_subs_epu8(x, y), _mm_subs_epu8(y, x));
+
+    __m128i within = _mm_cmpeq_epi32(_mm_subs_epu8(d, limit), zero);
+
+    maximum = _mm_max_epu8(maximum, d);
+    different +=
+        4 - __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(within)));
+  }
+
+  uint8_t bytes[16];
+
+  _mm_storeu_si128((__m128i*)bytes, maximum);
+  max_channel = std::max(max_channel, *std::max_element(bytes, bytes + 16));
+
+  return index;
+}
+
+TARGET_AVX2 static size_t compare_tolerance_avx2(const uint32_t* a,
+                                                 const uint32_t* b,
+                                                 size_t          count,
+                                                 uint8_t         tolerance,
+                                                 size_t&         different,
+                                                 uint8_t&        max_channel) {
+  const __m256i limit = _mm256_set1_epi8((char)tolerance);
+  const __m256i zero  = _mm256_setzero_si256();
+
+  __m256i maximum = _mm256_setzero_si256();
+  size_t  index   = 0;
+
+  for(; index + 8 <= count; index += 8) {
+    __m256i x = _mm256_loadu_si256((const __m256i*)(a + index));
+    __m256i y = _mm256_loadu_si256((const __m256i*)(b + index));
+    __m256i d = _mm256_or_si256(_mm256_subs_epu8(x, y), _mm256_subs_epu8(y, x));
+
+    __m256i within = _mm256_cmpeq_epi32(_mm256_subs_epu8(d, limit), zero);
+
+    maximum = _mm256_max_epu8(maximum, d);
+    different +=
+        8 - __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(within)));
+  }
+
+  uint8_t bytes[32];
+
+  _mm256_storeu_si256((__m256i*)bytes, maximum);
+  max_channel = std::max(max_channel, *std::max_element(bytes, bytes + 32));
+
+  return index;
+}
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+
+static size_t count_different_neon(const uint32_t* a,
+                                   const uint32_t* b,
+                                   size_t          count,
+                                   size_t&         different) {
+  size_t index = 0;
+
+  for(; index + 4 <= count; index += 4) {
+    uint32x4_t equal = vceqq_u32(vld1q_u32(a + index), vld1q_u32(b + index));
+
+    different += 4 - vaddvq_u32(vshrq_n_u32(equal, 31));
+  }
+
+  return index;
+}
+
+static size_t compare_tolerance_neon(const uint32_t* a,
+                                     const uint32_t* b,
+                                     size_t          count,
+                                     uint8_t         tolerance,
+                                     size_t&         different,
+                                     uint8_t&        max_channel) {
+  const uint8x16_t limit = vdupq_n_u8(tolerance);
+
+  uint8x16_t maximum = vdupq_n_u8(0);
+  size_t     index   = 0;
+
+  for(; index + 4 <= count; index += 4) {
+    uint8x16_t d = vabdq_u8(vld1q_u8((const uint8_t*)(a + index)),
+                            vld1q_u8((const uint8_t*)(b + index)));
+
+    uint32x4_t over = vtstq_u32(vreinterpretq_u32_u8(vcgtq_u8(d, limit)),
+                                vdupq_n_u32(0xFFFFFFFF));
+
+    maximum = vmaxq_u8(maximum, d);
+    different += vaddvq_u32(vshrq_n_u32(over, 31));
+  }
+
+  max_channel = std::max(max_channel, vmaxvq_u8(maximum));
+
+  return index;
+}
+
+#endif
+
+static size_t count_different_row(const uint32_t* a,
+                                  const uint32_t* b,
+                                  size_t          count,
+                                  bool            use_avx2) {
+  size_t different = 0;
+  size_t index     = 0;
+
+#if defined(__x86_64__)
+  index = use_avx2 ? count_different_avx2(a, b, count, different)
+                   : count_different_sse2(a, b, count, different);
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  index = count_different_neon(a, b, count, different);
+#endif
+
+  for(; index < count; index++) {
+    different += a[index] != b[index];
+  }
+
+  return different;
+}
+
+static bool has_avx2() {
+#if defined(__x86_64__)
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+size_t count_different_pixels(framebuffer_view_t a, framebuffer_view_t b) {
+  bool   use_avx2  = has_avx2();
+  size_t different = 0;
+
+  for(int32_t y = 0; y < a.height; y++) {
+    different += count_different_row(a.pixels + (size_t)y * a.stride,
+                                     b.pixels + (size_t)y * b.stride,
+                                     a.width,
+                                     use_avx2);
+  }
+
+  return different;
+}
+
+image_difference_s compare_images(framebuffer_view_t a,
+                                  framebuffer_view_t b,
+                                  int32_t            tolerance) {
+  uint8_t limit       = (uint8_t)std::clamp(tolerance, 0, 255);
+  bool    use_avx2    = has_avx2();
+  size_t  different   = 0;
+  uint8_t max_channel = 0;
+
+  for(int32_t y = 0; y < a.height; y++) {
+    const uint32_t* row_a = a.pixels + (size_t)y * a.stride;
+    const uint32_t* row_b = b.pixels + (size_t)y * b.stride;
+    size_t          index = 0;
+
+#if defined(__x86_64__)
+    if(use_avx2) {
+      index = compare_tolerance_avx2(row_a,
+                                     row_b,
+                                     a.width,
+                                     limit,
+                                     different,
+                                     max_channel);
+    } else {
+      index = compare_tolerance_sse2(row_a,
+                                     row_b,
+                                     a.width,
+                                     limit,
+                                     different,
+                                     max_channel);
+    }
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    index = compare_tolerance_neon(row_a,
+                                   row_b,
+                                   a.width,
+                                   limit,
+                                   different,
+                                   max_channel);
+#endif
+
+    for(; index < (size_t)a.width; index++) {
+      bool over = false;
+
+      for(int32_t shift = 0; shift < 32; shift += 8) {
+        int32_t x = (row_a[index] >> shift) & 0xFF;
+        int32_t y = (row_b[index] >> shift) & 0xFF;
+        int32_t d = x > y ? x - y : y - x;
+
+        over        = over || d > limit;
+        max_channel = std::max(max_channel, (uint8_t)d);
+      }
+
+      different += over;
+    }
+  }
+
+  return image_difference_s{ different, max_channel };
+}
+
+static constexpr uint64_t HASH_SEED       = 0x9E3779B97F4A7C15;
+static constexpr uint64_t HASH_MULTIPLIER = 0xFF51AFD7ED558CCD;
+
+static uint64_t hash_pixels(uint64_t        hash,
+                            const uint32_t* pixels,
+                            size_t          count) {
+  size_t index = 0;
+
+  for(; index + 2 <= count; index += 2) {
+    uint64_t value;
+
+    std::memcpy(&value, pixels + index, sizeof(value));
+    hash = (hash ^ value) * HASH_MULTIPLIER;
+    hash ^= hash >> 32;
+  }
+
+  if(index < count) {
+    hash = (hash ^ pixels[index]) * HASH_MULTIPLIER;
+    hash ^= hash >> 32;
+  }
+
+  return hash;
+}
+
+static uint64_t finish_hash(uint64_t hash) {
+  hash ^= hash >> 33;
+  hash *= HASH_MULTIPLIER;
+  hash ^= hash >> 33;
+
+  return hash;
+}
+
+std::vector<uint64_t> hash_tiles(framebuffer_view_t image, int32_t tile_size) {
+  int32_t tiles_x = (image.width + tile_size - 1) / tile_size;
+  int32_t tiles_y = (image.height + tile_size - 1) / tile_size;
+
+  std::vector<uint64_t> hashes((size_t)tiles_x * tiles_y, HASH_SEED);
+
+  // Row by row, so every image row is read once and in order.
+  for(int32_t y = 0; y < image.height; y++) {
+    const uint32_t* row  = image.pixels + (size_t)y * image.stride;
+    uint64_t*       tile = hashes.data() + (size_t)(y / tile_size) * tiles_x;
+
+    for(int32_t tile_x = 0; tile_x < tiles_x; tile_x++) {
+      int32_t start = tile_x * tile_size;
+      int32_t count = std::min(tile_size, image.width - start);
+
+      tile[tile_x] = hash_pixels(tile[tile_x], row + start, count);
+    }
+  }
+
+  for(uint64_t& hash : hashes) {
+    hash = finish_hash(hash);
+  }
+
+  return hashes;
+}
+
+uint64_t image_checksum(framebuffer_view_t image) {
+  uint64_t hash = HASH_SEED ^ ((uint64_t)image.width << 32 | image.height);
+
+  for(int32_t y = 0; y < image.height; y++) {
+    hash = hash_pixels(hash,
+                       image.pixels + (size_t)y * image.stride,
+                       image.width);
+  }
+
+  return finish_hash(hash);
+}
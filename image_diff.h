@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "framebuffer.h"
+#include "util.h"
+
+// Reads the binary PPM (P6) and PAM (P7, RGB or RGB_ALPHA) images that
+// image_writer produces, one after the other, so the streams written by
+// image_writer::append can be compared frame by frame. The file is mapped
+// rather than read, which keeps long streams cheap.
+class image_reader {
+  public:
+    image_reader() = default;
+    ~image_reader();
+
+    image_reader(const image_reader&)            = delete;
+    image_reader& operator=(const image_reader&) = delete;
+
+    bool open(const char* filename);
+    void close();
+
+    // Decodes the next image into image, reallocating it only when the size
+    // changes. Returns false at the end of the file and on malformed input;
+    // failed() tells the two apart.
+    bool read(framebuffer& image);
+
+    bool failed() const;
+
+  private:
+    const uint8_t* data   = nullptr;
+    size_t         size   = 0;
+    size_t         offset = 0;
+    bool           error  = false;
+};
+
+struct image_difference_s {
+    // Pixels with at least one channel differing by more than the tolerance.
+    size_t pixels;
+
+    // Largest difference of any channel, alpha included.
+    int32_t max_channel;
+};
+
+// Exact comparison, four (SSE2, NEON) or eight (AVX2) pixels per compare.
+// Both views must have the same size; only the strides may differ.
+size_t count_different_pixels(framebuffer_view_t a, framebuffer_view_t b);
+
+// Per-channel comparison: a pixel differs once any of its channels is more
+// than tolerance apart.
+image_difference_s compare_images(framebuffer_view_t a,
+                                  framebuffer_view_t b,
+                                  int32_t            tolerance);
+
+// One 64-bit hash per tile_size square tile, in row-major tile order. Tiles
+// along the right and bottom edges are cut to the image. Comparing two lists
+// points at the regions that changed without keeping the pixels around.
+std::vector<uint64_t> hash_tiles(framebuffer_view_t image, int32_t tile_size);
+
+// Hash of all pixels, for recording golden checksums.
+uint64_t image_checksum(framebuffer_view_t image);
@@ -0,0 +1,438 @@
+#include "image_writer.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__x86_64__)
+# include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+#endif
+
+#include "image_compress.h"
+
+static constexpr size_t HEADER_SIZE = 128;
+
+static bool is_compressed(image_format_e format) {
+  return format == IMAGE_FORMAT_QOI || format == IMAGE_FORMAT_PNG;
+}
+
+image_format_e image_format_for_filename(const char*    filename,
+                                         image_format_e fallback) {
+  static constexpr struct {
+      const char*    extension;
+      image_format_e format;
+  } EXTENSIONS[] = {
+    { ".ppm", IMAGE_FORMAT_PPM },
+    { ".pam", IMAGE_FORMAT_PAM },
+    { ".qoi", IMAGE_FORMAT_QOI },
+    { ".png", IMAGE_FORMAT_PNG },
+  };
+
+  const char* extension = std::strrchr(filename, '.');
+
+  if(extension == nullptr || std::strlen(extension) != 4) {
+    return fallback;
+  }
+
+  for(const auto& entry : EXTENSIONS) {
+    bool match = true;
+
+    for(size_t index = 0; index < 4; index++) {
+      match = match && std::tolower((unsigned char)extension[index]) ==
+                           entry.extension[index];
+    }
+
+    if(match) {
+      return entry.format;
+    }
+  }
+
+  return fallback;
+}
+
+#if defined(__x86_64__)
+
+# define TARGET_SSSE3 __attribute__((target("ssse3")))
+
+// Every 16 byte load holds four pixels; the shuffle packs their twelve color
+// bytes to the bottom and the shifts splice four loads into three stores.
+TARGET_SSSE3 static size_t
+convert_rgba_to_rgb_ssse3(uint8_t*        destination,
+                          const uint32_t* source,
+                          size_t          count) {
+  const __m128i shuffle = _mm_setr_epi8(0,
+                                        1,
+                                        2,
+                                        4,
+                                        5,
+                                        6,
+                                        8,
+                                        9,
+                                        10,
+                                        12,
+                                        13,
+                                        14,
+                                        -1,
+                                        -1,
+                                        -1,
+                                        -1);
+
+  size_t index = 0;
+
+  for(; index + 16 <= count; index += 16) {
+    const __m128i* input  = (const __m128i*)(source + index);
+    __m128i*       output = (__m128i*)(destination + index * 3);
+
+    __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(input + 0), shuffle);
+    __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(input + 1), shuffle);
+    __m128i c = _mm_shuffle_epi8(_mm_loadu_si128(input + 2), shuffle);
+    __m128i d = _mm_shuffle_epi8(_mm_loadu_si128(input + 3), shuffle);
+
+    _mm_storeu_si128(output + 0, _mm_or_si128(a, _mm_slli_si128(b, 12)));
+    _mm_storeu_si128(output + 1,
+                     _mm_or_si128(_mm_srli_si128(b, 4), _mm_slli_si128(c, 8)));
+    _mm_storeu_si128(output + 2,
+                     _mm_or_si128(_mm_srli_si128(c, 8), _mm_slli_si128(d, 4)));
+  }
+
+  return index;
+}
+
+#endif
+
+void convert_rgba_to_rgb(uint8_t*        destination,
+                         const uint32_t* source,
+                         size_t          count) {
+  size_t index = 0;
+
+#if defined(__x86_64__)
+
+  if(__builtin_cpu_supports("ssse3")) {
+    index = convert_rgba_to_rgb_ssse3(destination, source, count);
+  }
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+
+  for(; index + 16 <= count; index += 16) {
+    uint8x16x4_t rgba = vld4q_u8((const uint8_t*)(source + index));
+    uint8x16x3_t rgb  = { { rgba.val[0], rgba.val[1], rgba.val[2] } };
+
+    vst3q_u8(destination + index * 3, rgb);
+  }
+
+#endif
+
+  for(; index < count; index++) {
+    uint32_t color = source[index];
+
+    destination[index * 3 + 0] = (color >> 0) & 0xFF;
+    destination[index * 3 + 1] = (color >> 8) & 0xFF;
+    destination[index * 3 + 2] = (color >> 16) & 0xFF;
+  }
+}
+
+// Packed pixels are laid out r, g, b, a in memory on little endian hosts,
+// which is exactly the PAM RGB_ALPHA tuple order.
+static void convert_rgba_to_rgba(uint8_t*        destination,
+                                 const uint32_t* source,
+                                 size_t          count) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  std::memcpy(destination, source, count * 4);
+#else
+  for(size_t index = 0; index < count; index++) {
+    uint32_t color = source[index];
+
+    destination[index * 4 + 0] = (color >> 0) & 0xFF;
+    destination[index * 4 + 1] = (color >> 8) & 0xFF;
+    destination[index * 4 + 2] = (color >> 16) & 0xFF;
+    destination[index * 4 + 3] = (color >> 24) & 0xFF;
+  }
+#endif
+}
+
+// Converts an image whose rows are image_stride pixels apart into tightly
+// packed PPM or PAM pixels.
+static void convert_pixels(uint8_t*        destination,
+                           image_format_e  format,
+                           const uint32_t* image,
+                           int32_t         image_width,
+                           int32_t         image_height,
+                           int32_t         image_stride) {
+  size_t pixel_size = format == IMAGE_FORMAT_PAM ? 4 : 3;
+  size_t rows       = image_stride == image_width ? 1 : image_height;
+  size_t count      = image_stride == image_width
+                          ? (size_t)image_width * image_height
+                          : (size_t)image_width;
+
+  for(size_t row = 0; row < rows; row++) {
+    uint8_t*        output = destination + row * count * pixel_size;
+    const uint32_t* input  = image + row * image_stride;
+
+    if(format == IMAGE_FORMAT_PAM) {
+      convert_rgba_to_rgba(output, input, count);
+    } else {
+      convert_rgba_to_rgb(output, input, count);
+    }
+  }
+}
+
+static bool write_all(int32_t file, struct iovec* vectors, int32_t count) {
+  while(count > 0) {
+    ssize_t written = writev(file, vectors, count);
+
+    if(written < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if(written < 0) {
+      return false;
+    }
+
+    while(count > 0 && (size_t)written >= vectors->iov_len) {
+      written -= vectors->iov_len;
+      vectors++;
+      count--;
+    }
+
+    if(count > 0) {
+      vectors->iov_base = (uint8_t*)vectors->iov_base + written;
+      vectors->iov_len -= written;
+    }
+  }
+
+  return true;
+}
+
+size_t format_image_header(char*          header,
+                           size_t         header_size,
+                           image_format_e format,
+                           int32_t        image_width,
+                           int32_t        image_height) {
+  int32_t length = 0;
+
+  if(is_compressed(format)) {
+    return 0;
+  }
+
+  if(format == IMAGE_FORMAT_PAM) {
+    length = std::snprintf(header,
+                           header_size,
+                           "P7\nWIDTH %d\nHEIGHT %d\nDEPTH 4\nMAXVAL 255\n"
+                           "TUPLTYPE RGB_ALPHA\nENDHDR\n",
+                           image_width,
+                           image_height);
+  } else {
+    length = std::snprintf(header,
+                           header_size,
+                           "P6\n%d %d\n255\n",
+                           image_width,
+                           image_height);
+  }
+
+  return (size_t)length;
+}
+
+void encode_image(std::vector<uint8_t>& output,
+                  image_format_e        format,
+                  const uint32_t*       image,
+                  int32_t               image_width,
+                  int32_t               image_height,
+                  int32_t               image_stride) {
+  if(format == IMAGE_FORMAT_QOI) {
+    encode_qoi(output, image, image_width, image_height, image_stride);
+    return;
+  }
+
+  if(format == IMAGE_FORMAT_PNG) {
+    encode_png(output, image, image_width, image_height, image_stride);
+    return;
+  }
+
+  char   header[HEADER_SIZE];
+  size_t header_length = format_image_header(header,
+                                             sizeof(header),
+                                             format,
+                                             image_width,
+                                             image_height);
+  size_t count         = (size_t)image_width * image_height;
+  size_t pixel_size    = format == IMAGE_FORMAT_PAM ? 4 : 3;
+
+  output.resize(header_length + count * pixel_size);
+  std::memcpy(output.data(), header, header_length);
+
+  convert_pixels(output.data() + header_length,
+                 format,
+                 image,
+                 image_width,
+                 image_height,
+                 image_stride);
+}
+
+image_writer::image_writer(image_format_e format)
+  : format{ format } {
+}
+
+image_writer::~image_writer() {
+  close_stream();
+}
+
+bool image_writer::write_image(int32_t         file,
+                               const uint32_t* image,
+                               int32_t         image_width,
+                               int32_t         image_height,
+                               int32_t         image_stride) {
+  if(is_compressed(format)) {
+    encode_image(buffer,
+                 format,
+                 image,
+                 image_width,
+                 image_height,
+                 image_stride);
+
+    struct iovec vector;
+
+    vector.iov_base = buffer.data();
+    vector.iov_len  = buffer.size();
+
+    return write_all(file, &vector, 1);
+  }
+
+  char   header[HEADER_SIZE];
+  size_t header_length = format_image_header(header,
+                                             sizeof(header),
+                                             format,
+                                             image_width,
+                                             image_height);
+  size_t count      = (size_t)image_width * image_height;
+  size_t pixel_size = format == IMAGE_FORMAT_PAM ? 4 : 3;
+
+  struct iovec vectors[2];
+
+  vectors[0].iov_base = header;
+  vectors[0].iov_len  = header_length;
+  vectors[1].iov_len  = count * pixel_size;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  if(format == IMAGE_FORMAT_PAM && image_stride == image_width) {
+    vectors[1].iov_base = (void*)image;
+
+    return write_all(file, vectors, 2);
+  }
+#endif
+
+  buffer.resize(count * pixel_size);
+  convert_pixels(buffer.data(),
+                 format,
+                 image,
+                 image_width,
+                 image_height,
+                 image_stride);
+  vectors[1].iov_base = buffer.data();
+
+  return write_all(file, vectors, 2);
+}
+
+bool image_writer::write(const char*     filename,
+                         const uint32_t* image,
+                         int32_t         image_width,
+                         int32_t         image_height,
+                         int32_t         image_stride) {
+  int32_t file = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+  if(file < 0) {
+    return false;
+  }
+
+  bool result =
+      write_image(file, image, image_width, image_height, image_stride);
+
+  return close(file) == 0 && result;
+}
+
+bool image_writer::write_mapped(const char*     filename,
+                                const uint32_t* image,
+                                int32_t         image_width,
+                                int32_t         image_height,
+                                int32_t         image_stride) {
+  if(is_compressed(format)) {
+    return write(filename, image, image_width, image_height, image_stride);
+  }
+
+  char   header[HEADER_SIZE];
+  size_t header_length = format_image_header(header,
+                                             sizeof(header),
+                                             format,
+                                             image_width,
+                                             image_height);
+  size_t count      = (size_t)image_width * image_height;
+  size_t pixel_size = format == IMAGE_FORMAT_PAM ? 4 : 3;
+  size_t total      = header_length + count * pixel_size;
+
+  int32_t file = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+  if(file < 0) {
+    return false;
+  }
+
+  if(ftruncate(file, (off_t)total) != 0) {
+    close(file);
+    return false;
+  }
+
+  void* mapping = mmap(nullptr, total, PROT_WRITE, MAP_SHARED, file, 0);
+
+  if(mapping == MAP_FAILED) {
+    close(file);
+    return false;
+  }
+
+  uint8_t* bytes = (uint8_t*)mapping;
+
+  std::memcpy(bytes, header, header_length);
+  convert_pixels(bytes + header_length,
+                 format,
+                 image,
+                 image_width,
+                 image_height,
+                 image_stride);
+
+  bool result = munmap(mapping, total) == 0;
+
+  return close(file) == 0 && result;
+}
+
+bool image_writer::open_stream(const char* filename) {
+  close_stream();
+
+  stream = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+  return stream >= 0;
+}
+
+bool image_writer::append(const uint32_t* image,
+                          int32_t         image_width,
+                          int32_t         image_height,
+                          int32_t         image_stride) {
+  if(stream < 0) {
+    return false;
+  }
+
+  return write_image(stream, image, image_width, image_height, image_stride);
+}
+
+void image_writer::close_stream() {
+  if(stream >= 0) {
+    close(stream);
+    stream = -1;
+  }
+}
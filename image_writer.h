@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum image_format_e {
+  IMAGE_FORMAT_PPM,
+  IMAGE_FORMAT_PAM,
+  IMAGE_FORMAT_QOI,
+  IMAGE_FORMAT_PNG,
+};
+
+// Picks the format from the extension of filename (.ppm, .pam, .qoi or .png,
+// in any case) and falls back to fallback for anything else.
+image_format_e image_format_for_filename(const char*    filename,
+                                         image_format_e fallback);
+
+// Converts packed pixels (see pack_color) to 8-bit RGB triples, dropping the
+// alpha channel. Uses SSSE3 or NEON shuffles for 16 pixels at a time.
+void convert_rgba_to_rgb(uint8_t*        destination,
+                         const uint32_t* source,
+                         size_t          count);
+
+// Writes the PPM or PAM header for an image into header and returns its
+// length. 128 bytes are always enough. The compressed formats write their
+// headers while encoding, so for them the length is zero.
+size_t format_image_header(char*          header,
+                           size_t         header_size,
+                           image_format_e format,
+                           int32_t        image_width,
+                           int32_t        image_height);
+
+// Header followed by the converted pixels, ready to be written as is. QOI and
+// PNG go through encode_qoi and encode_png.
+void encode_image(std::vector<uint8_t>& output,
+                  image_format_e        format,
+                  const uint32_t*       image,
+                  int32_t               image_width,
+                  int32_t               image_height,
+                  int32_t               image_stride);
+
+// Writes framebuffers as binary PPM (P6) or PAM (P7, RGB_ALPHA) images. The
+// header and the pixels leave in a single writev. PPM pixels are converted
+// into a buffer that is kept across calls; PAM pixels already have the file's
+// byte order and are handed to the kernel straight from the framebuffer.
+// Rows are image_stride pixels apart; padded rows are packed while converting.
+// QOI and PNG images are encoded into the buffer first and written from there.
+class image_writer {
+  public:
+    explicit image_writer(image_format_e format = IMAGE_FORMAT_PPM);
+    ~image_writer();
+
+    image_writer(const image_writer&)            = delete;
+    image_writer& operator=(const image_writer&) = delete;
+
+    bool write(const char*     filename,
+               const uint32_t* image,
+               int32_t         image_width,
+               int32_t         image_height,
+               int32_t         image_stride);
+
+    // Sizes the file up front, maps it and converts the pixels directly into
+    // the mapping, so no intermediate buffer is involved. The size of a
+    // compressed image is not known up front, so those take the write path.
+    bool write_mapped(const char*     filename,
+                      const uint32_t* image,
+                      int32_t         image_width,
+                      int32_t         image_height,
+                      int32_t         image_stride);
+
+    // Streaming mode: every appended frame is written as a complete image
+    // right after the previous one in a single open file, which the netpbm
+    // tools and ffmpeg read as an image sequence.
+    bool open_stream(const char* filename);
+    bool append(const uint32_t* image,
+                int32_t         image_width,
+                int32_t         image_height,
+                int32_t         image_stride);
+    void close_stream();
+
+  private:
+    bool write_image(int32_t         file,
+                     const uint32_t* image,
+                     int32_t         image_width,
+                     int32_t         image_height,
+                     int32_t         image_stride);
+
+    image_format_e       format;
+    std::vector<uint8_t> buffer;
+    int32_t              stream = -1;
+};
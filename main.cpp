@@ -6,7 +6,10 @@
 #include <bitset>
 
 #include "util.h"
+#include "framebuffer.h"
 #include "bit_field.h"
+#include "procedural_texture.h"
+#include "thread_pool.h"
 
 struct color_3_f {
     float r;
@@ -14,37 +17,36 @@ struct color_3_f {
     float b;
 };
 
+static constexpr uint32_t RANDOM_PATTERN_SEED = 1;
+
 void generate_random_pattern() {
   uint32_t                 image_width  = 512;
   uint32_t                 image_height = 512;
   std::array<color_3_f, 3> rock_colors;
+  std::array<uint32_t, 3>  palette;
 
   rock_colors[0] = { 0.4078f, 0.4078f, 0.3764f };
   rock_colors[1] = { 0.7606f, 0.6274f, 0.6313f };
   rock_colors[2] = { 0.8980f, 0.9372f, 0.9725f };
 
-  std::vector<uint32_t> framebuffer{};
-
-  framebuffer.resize(image_width * image_height);
+  for(size_t index = 0; index < rock_colors.size(); index++) {
+    uint32_t r = rock_colors[index].r * 255;
+    uint32_t g = rock_colors[index].g * 255;
+    uint32_t b = rock_colors[index].b * 255;
 
-  for(uint32_t x = 0; x < image_width; x++) {
-    for(uint32_t y = 0; y < image_height; y++) {
-      size_t color_index = std::min(size_t(drand48() * rock_colors.size()),
-                                    rock_colors.size() - 1);
+    palette[index] = pack_color(r, g, b, 255);
+  }
 
-      uint32_t r = rock_colors[color_index].r * 255;
-      uint32_t g = rock_colors[color_index].g * 255;
-      uint32_t b = rock_colors[color_index].b * 255;
-      uint32_t c = pack_color(r, g, b, 255);
+  framebuffer image{ (int32_t)image_width, (int32_t)image_height };
+  thread_pool pool;
 
-      framebuffer[x + y * image_width] = c;
-    }
-  }
+  fill_random_pattern(image.view(),
+                      palette.data(),
+                      palette.size(),
+                      RANDOM_PATTERN_SEED,
+                      &pool);
 
-  write_framebuffer("random_pattern.ppm",
-                    framebuffer.data(),
-                    image_width,
-                    image_height);
+  write_framebuffer_view("random_pattern.ppm", image.view());
 }
 
 struct noise_operator {
@@ -95,6 +97,8 @@ union generic_instruction {
 };
 
 int32_t main(int32_t argument_count, char** arguments) {
+  generate_random_pattern();
+
   generic_instruction ins{ 0b00000000101101010000010100111011 };
 
   std::cout << std::bitset<7>{ ins.opcode.Value() } << std::endl;
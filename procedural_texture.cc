@@ -0,0 +1,343 @@
+#include "procedural_texture.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__)
+# include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+#endif
+
+static constexpr uint32_t PHILOX_MULTIPLIER = 0xD256D345;
+static constexpr uint32_t PHILOX_KEY_STEP   = 0x9E3779B9;
+static constexpr int32_t  PHILOX_ROUNDS     = 10;
+
+// Rows per task when the fill is spread over a pool.
+static constexpr int32_t PATTERN_ROW_CHUNK = 16;
+
+uint32_t philox_2x32(uint32_t counter_0, uint32_t counter_1, uint32_t key) {
+  for(int32_t round = 0; round < PHILOX_ROUNDS; round++) {
+    uint64_t product = (uint64_t)PHILOX_MULTIPLIER * counter_0;
+
+    counter_0 = (uint32_t)(product >> 32) ^ key ^ counter_1;
+    counter_1 = (uint32_t)product;
+    key += PHILOX_KEY_STEP;
+  }
+
+  return counter_0;
+}
+
+// High half of value * range, which maps a uniform 32-bit value to a uniform
+// index below range without a division.
+static uint32_t scale_to_range(uint32_t value, uint32_t range) {
+  return (uint32_t)(((uint64_t)value * range) >> 32);
+}
+
+size_t random_pattern_index(uint32_t x,
+                            uint32_t y,
+                            uint32_t seed,
+                            size_t   palette_size) {
+  return scale_to_range(philox_2x32(x, y, seed), (uint32_t)palette_size);
+}
+
+static void fill_row_scalar(uint32_t*       row,
+                            uint32_t        begin,
+                            uint32_t        end,
+                            uint32_t        y,
+                            const uint32_t* palette,
+                            size_t          palette_size,
+                            uint32_t        seed) {
+  for(uint32_t x = begin; x < end; x++) {
+    row[x] = palette[random_pattern_index(x, y, seed, palette_size)];
+  }
+}
+
+#if defined(__x86_64__)
+
+# define TARGET_AVX2 __attribute__((target("avx2")))
+
+// High and low halves of the 64-bit products of four 32-bit lanes by factor.
+// _mm_mul_epu32 only multiplies the even lanes, so the odd ones go through
+// it shifted down.
+static inline void multiply_wide_sse2(__m128i  value,
+                                      __m128i  factor,
+                                      __m128i& high,
+                                      __m128i& low) {
+  __m128i even = _mm_mul_epu32(value, factor);
+  __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(value, 32), factor);
+
+  high = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 3, 1)),
+                            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 3, 1)));
+  low  = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static inline __m128i philox_2x32_sse2(__m128i  counter_0,
+                                       __m128i  counter_1,
+                                       uint32_t key) {
+  const __m128i multiplier = _mm_set1_epi32((int32_t)PHILOX_MULTIPLIER);
+
+  for(int32_t round = 0; round < PHILOX_ROUNDS; round++) {
+    __m128i high;
+    __m128i low;
+
+    multiply_wide_sse2(counter_0, multiplier, high, low);
+
+    counter_0 = _mm_xor_si128(_mm_xor_si128(high, _mm_set1_epi32((int32_t)key)),
+                              counter_1);
+    counter_1 = low;
+    key += PHILOX_KEY_STEP;
+  }
+
+  return counter_0;
+}
+
+// Fills [begin, end) of one row four pixels at a time and returns where it
+// stopped; the remaining pixels are left for the scalar loop. SSE2 has no
+// lane permute, so the palette is read lane by lane.
+static uint32_t fill_row_sse2(uint32_t*       row,
+                              uint32_t        begin,
+                              uint32_t        end,
+                              uint32_t        y,
+                              const uint32_t* palette,
+                              size_t          palette_size,
+                              uint32_t        seed) {
+  const __m128i range   = _mm_set1_epi32((int32_t)palette_size);
+  const __m128i lanes   = _mm_setr_epi32(0, 1, 2, 3);
+  const __m128i counter = _mm_set1_epi32((int32_t)y);
+
+  alignas(16) uint32_t indices[4];
+  uint32_t             x = begin;
+
+  for(; x + 4 <= end; x += 4) {
+    __m128i position = _mm_add_epi32(_mm_set1_epi32((int32_t)x), lanes);
+    __m128i value    = philox_2x32_sse2(position, counter, seed);
+    __m128i index;
+    __m128i low;
+
+    multiply_wide_sse2(value, range, index, low);
+    _mm_store_si128((__m128i*)indices, index);
+
+    for(size_t lane = 0; lane < 4; lane++) {
+      row[x + lane] = palette[indices[lane]];
+    }
+  }
+
+  return x;
+}
+
+// Full 64-bit products of eight 32-bit lanes by factor, split into their
+// high and low halves. _mm256_mul_epu32 only multiplies the even lanes, so
+// the odd ones go through it shifted down.
+TARGET_AVX2 static inline void multiply_wide_avx2(__m256i  value,
+                                                  __m256i  factor,
+                                                  __m256i& high,
+                                                  __m256i& low) {
+  __m256i even = _mm256_mul_epu32(value, factor);
+  __m256i odd  = _mm256_mul_epu32(_mm256_srli_epi64(value, 32), factor);
+
+  high = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+  low  = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+}
+
+// philox_2x32 for eight pairs of counters.
+TARGET_AVX2 static inline __m256i philox_2x32_avx2(__m256i  counter_0,
+                                                   __m256i  counter_1,
+                                                   uint32_t key) {
+  const __m256i multiplier = _mm256_set1_epi32((int32_t)PHILOX_MULTIPLIER);
+
+  for(int32_t round = 0; round < PHILOX_ROUNDS; round++) {
+    __m256i high;
+    __m256i low;
+
+    multiply_wide_avx2(counter_0, multiplier, high, low);
+
+    counter_0 = _mm256_xor_si256(
+        _mm256_xor_si256(high, _mm256_set1_epi32((int32_t)key)), counter_1);
+    counter_1 = low;
+    key += PHILOX_KEY_STEP;
+  }
+
+  return counter_0;
+}
+
+// The SSE2 row eight pixels at a time. Palettes of up to eight colors fit in
+// one register and are looked up with a permute, larger ones are gathered.
+TARGET_AVX2 static uint32_t fill_row_avx2(uint32_t*       row,
+                                          uint32_t        begin,
+                                          uint32_t        end,
+                                          uint32_t        y,
+                                          const uint32_t* palette,
+                                          size_t          palette_size,
+                                          uint32_t        seed) {
+  const __m256i range   = _mm256_set1_epi32((int32_t)palette_size);
+  const __m256i lanes   = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i counter = _mm256_set1_epi32((int32_t)y);
+  const bool    permute = palette_size <= 8;
+
+  alignas(32) uint32_t colors[8] = {};
+
+  std::copy(palette, palette + std::min<size_t>(palette_size, 8), colors);
+
+  __m256i  table = _mm256_load_si256((const __m256i*)colors);
+  uint32_t x     = begin;
+
+  for(; x + 8 <= end; x += 8) {
+    __m256i position = _mm256_add_epi32(_mm256_set1_epi32((int32_t)x), lanes);
+    __m256i value    = philox_2x32_avx2(position, counter, seed);
+    __m256i index;
+    __m256i low;
+
+    multiply_wide_avx2(value, range, index, low);
+
+    __m256i color = permute
+                        ? _mm256_permutevar8x32_epi32(table, index)
+                        : _mm256_i32gather_epi32((const int32_t*)palette,
+                                                 index,
+                                                 4);
+
+    _mm256_storeu_si256((__m256i*)(row + x), color);
+  }
+
+  return x;
+}
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+
+// High and low halves of the 64-bit products of four 32-bit lanes by
+// factor.
+static inline void multiply_wide_neon(uint32x4_t  value,
+                                      uint32x2_t  factor,
+                                      uint32x4_t& high,
+                                      uint32x4_t& low) {
+  uint64x2_t first  = vmull_u32(vget_low_u32(value), factor);
+  uint64x2_t second = vmull_u32(vget_high_u32(value), factor);
+
+  uint32x4x2_t halves = vuzpq_u32(vreinterpretq_u32_u64(first),
+                                  vreinterpretq_u32_u64(second));
+
+  low  = halves.val[0];
+  high = halves.val[1];
+}
+
+static inline uint32x4_t philox_2x32_neon(uint32x4_t counter_0,
+                                          uint32x4_t counter_1,
+                                          uint32_t   key) {
+  const uint32x2_t multiplier = vdup_n_u32(PHILOX_MULTIPLIER);
+
+  for(int32_t round = 0; round < PHILOX_ROUNDS; round++) {
+    uint32x4_t high;
+    uint32x4_t low;
+
+    multiply_wide_neon(counter_0, multiplier, high, low);
+
+    counter_0 = veorq_u32(veorq_u32(high, vdupq_n_u32(key)), counter_1);
+    counter_1 = low;
+    key += PHILOX_KEY_STEP;
+  }
+
+  return counter_0;
+}
+
+// The SSE2 row, with the same lane by lane palette lookup.
+static uint32_t fill_row_neon(uint32_t*       row,
+                              uint32_t        begin,
+                              uint32_t        end,
+                              uint32_t        y,
+                              const uint32_t* palette,
+                              size_t          palette_size,
+                              uint32_t        seed) {
+  const uint32x2_t range   = vdup_n_u32((uint32_t)palette_size);
+  const uint32x4_t counter = vdupq_n_u32(y);
+  const uint32_t   offsets[4] = { 0, 1, 2, 3 };
+  const uint32x4_t lanes   = vld1q_u32(offsets);
+
+  uint32_t indices[4];
+  uint32_t x = begin;
+
+  for(; x + 4 <= end; x += 4) {
+    uint32x4_t position = vaddq_u32(vdupq_n_u32(x), lanes);
+    uint32x4_t value    = philox_2x32_neon(position, counter, seed);
+    uint32x4_t index;
+    uint32x4_t low;
+
+    multiply_wide_neon(value, range, index, low);
+    vst1q_u32(indices, index);
+
+    for(size_t lane = 0; lane < 4; lane++) {
+      row[x + lane] = palette[indices[lane]];
+    }
+  }
+
+  return x;
+}
+
+#endif
+
+static void fill_rows(framebuffer_view_t view,
+                      int32_t            begin,
+                      int32_t            end,
+                      const uint32_t*    palette,
+                      size_t             palette_size,
+                      uint32_t           seed,
+                      bool               use_avx2) {
+  for(int32_t y = begin; y < end; y++) {
+    uint32_t* row   = view.pixels + (size_t)y * view.stride;
+    uint32_t  width = (uint32_t)view.width;
+    uint32_t  x     = 0;
+
+#if defined(__x86_64__)
+    x = use_avx2 ? fill_row_avx2(row, 0, width, y, palette, palette_size, seed)
+                 : fill_row_sse2(row, 0, width, y, palette, palette_size, seed);
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    x = fill_row_neon(row, 0, width, y, palette, palette_size, seed);
+#endif
+
+    fill_row_scalar(row, x, width, y, palette, palette_size, seed);
+  }
+}
+
+static bool has_avx2() {
+#if defined(__x86_64__)
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+void fill_random_pattern(framebuffer_view_t view,
+                         const uint32_t*    palette,
+                         size_t             palette_size,
+                         uint32_t           seed,
+                         thread_pool*       pool) {
+  bool use_avx2 = has_avx2();
+
+  if(pool == nullptr) {
+    fill_rows(view, 0, view.height, palette, palette_size, seed, use_avx2);
+    return;
+  }
+
+  size_t chunks = (view.height + PATTERN_ROW_CHUNK - 1) / PATTERN_ROW_CHUNK;
+
+  pool->parallel_for(chunks, [&](size_t chunk) {
+    int32_t begin = (int32_t)chunk * PATTERN_ROW_CHUNK;
+    int32_t end   = std::min(begin + PATTERN_ROW_CHUNK, view.height);
+
+    fill_rows(view, begin, end, palette, palette_size, seed, use_avx2);
+  });
+}
+
+void fill_random_pattern_scalar(framebuffer_view_t view,
+                                const uint32_t*    palette,
+                                size_t             palette_size,
+                                uint32_t           seed) {
+  for(int32_t y = 0; y < view.height; y++) {
+    fill_row_scalar(view.pixels + (size_t)y * view.stride,
+                    0,
+                    (uint32_t)view.width,
+                    (uint32_t)y,
+                    palette,
+                    palette_size,
+                    seed);
+  }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "thread_pool.h"
+#include "util.h"
+
+// Philox2x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2,
+// 3"): a counter-based generator, where the n-th random number is a keyed
+// hash of n instead of the next step of some shared state. Returns the first
+// of the two output words for the counter (counter_0, counter_1) under key.
+uint32_t philox_2x32(uint32_t counter_0, uint32_t counter_1, uint32_t key);
+
+// Palette entry that pixel (x, y) of the pattern with the given seed takes:
+// philox_2x32(x, y, seed) scaled to [0, palette_size). It depends on nothing
+// else, so pixels can be generated in any order and by any number of threads.
+size_t random_pattern_index(uint32_t x,
+                            uint32_t y,
+                            uint32_t seed,
+                            size_t   palette_size);
+
+// Fills view row by row with colors picked from palette by
+// random_pattern_index, eight pixels at a time with AVX2 (four with NEON).
+// Bands of rows are spread over pool when one is given. Every path writes
+// the same bits, whatever the thread count. palette_size must not be zero.
+void fill_random_pattern(framebuffer_view_t view,
+                         const uint32_t*    palette,
+                         size_t             palette_size,
+                         uint32_t           seed,
+                         thread_pool*       pool = nullptr);
+
+// The same one pixel at a time, as a reference for the vector paths.
+void fill_random_pattern_scalar(framebuffer_view_t view,
+                                const uint32_t*    palette,
+                                size_t             palette_size,
+                                uint32_t           seed);
@@ -0,0 +1,74 @@
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "framebuffer.h"
+#include "procedural_texture.h"
+#include "thread_pool.h"
+
+// Checks that the vector and threaded random pattern fills match the scalar
+// reference bit for bit, for pools of several sizes, palettes on both sides
+// of the eight color register lookup and widths that leave a tail.
+
+static constexpr uint32_t SEED = 1;
+
+static size_t count_differences(const framebuffer& expected,
+                                const framebuffer& actual) {
+  size_t differences = 0;
+
+  for(int32_t y = 0; y < expected.height(); y++) {
+    for(int32_t x = 0; x < expected.width(); x++) {
+      differences += actual.row(y)[x] != expected.row(y)[x];
+    }
+  }
+
+  return differences;
+}
+
+int32_t main() {
+  std::vector<uint32_t> palette(13);
+
+  for(size_t index = 0; index < palette.size(); index++) {
+    palette[index] = (uint32_t)(index * 2654435761u);
+  }
+
+  size_t errors = 0;
+
+  for(int32_t width : { 1, 7, 8, 509 }) {
+    int32_t height = 67;
+
+    framebuffer reference{ width, height };
+    framebuffer actual{ width, height };
+
+    for(size_t palette_size : { 1, 3, 8, 9, 13 }) {
+      fill_random_pattern_scalar(reference.view(),
+                                 palette.data(),
+                                 palette_size,
+                                 SEED);
+      fill_random_pattern(actual.view(), palette.data(), palette_size, SEED);
+
+      size_t differences = count_differences(reference, actual);
+
+      for(size_t thread_count : { 1, 2, 3, 8 }) {
+        thread_pool pool{ thread_count };
+
+        fill_random_pattern(actual.view(),
+                            palette.data(),
+                            palette_size,
+                            SEED,
+                            &pool);
+
+        differences += count_differences(reference, actual);
+      }
+
+      if(differences != 0) {
+        std::cerr << width << "x" << height << ", " << palette_size
+                  << " colors: " << differences
+                  << " pixels differ from scalar" << std::endl;
+        errors++;
+      }
+    }
+  }
+
+  return errors == 0 ? 0 : 1;
+}
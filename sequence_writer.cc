@@ -0,0 +1,637 @@
+#include "sequence_writer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Buffered bytes that trigger a write.
+static constexpr size_t FLUSH_SIZE = 1 << 20;
+
+// Identical changed pixels worth a run command rather than literals.
+static constexpr size_t MIN_RUN = 3;
+
+static constexpr char DELTA_SIGNATURE[] = "DRLE";
+static constexpr char Y4M_SIGNATURE[]   = "YUV4MPEG2 ";
+
+enum delta_command_e {
+  DELTA_COMMAND_SKIP,
+  DELTA_COMMAND_RUN,
+  DELTA_COMMAND_LITERAL,
+};
+
+sequence_format_e sequence_format_for_filename(const char*       filename,
+                                               sequence_format_e fallback) {
+  const char* extension = std::strrchr(filename, '.');
+
+  if(extension == nullptr) {
+    return fallback;
+  }
+
+  if(strcasecmp(extension, ".y4m") == 0) {
+    return SEQUENCE_FORMAT_Y4M;
+  }
+
+  if(strcasecmp(extension, ".drle") == 0) {
+    return SEQUENCE_FORMAT_DELTA;
+  }
+
+  return fallback;
+}
+
+bool is_sequence_filename(const char* filename) {
+  return sequence_format_for_filename(filename, SEQUENCE_FORMAT_Y4M) ==
+         sequence_format_for_filename(filename, SEQUENCE_FORMAT_DELTA);
+}
+
+static void put_u32(std::vector<uint8_t>& output, uint32_t value) {
+  output.push_back((uint8_t)value);
+  output.push_back((uint8_t)(value >> 8));
+  output.push_back((uint8_t)(value >> 16));
+  output.push_back((uint8_t)(value >> 24));
+}
+
+static void put_varint(std::vector<uint8_t>& output, uint64_t value) {
+  while(value >= 0x80) {
+    output.push_back((uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+
+  output.push_back((uint8_t)value);
+}
+
+static void put_command(std::vector<uint8_t>& output,
+                        delta_command_e       kind,
+                        size_t                count) {
+  put_varint(output, ((uint64_t)count << 2) | kind);
+}
+
+static void put_pixels(std::vector<uint8_t>& output,
+                       const uint32_t*       pixels,
+                       size_t                count) {
+  size_t start = output.size();
+
+  output.resize(start + count * sizeof(uint32_t));
+  std::memcpy(output.data() + start, pixels, count * sizeof(uint32_t));
+}
+
+sequence_writer::sequence_writer(sequence_format_e format)
+  : format{ format } {}
+
+sequence_writer::~sequence_writer() {
+  close();
+}
+
+bool sequence_writer::open(const char* filename) {
+  close();
+
+  if(std::strcmp(filename, "-") == 0) {
+    file = STDOUT_FILENO;
+  } else {
+    file = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  }
+
+  error = file < 0;
+
+  return !error;
+}
+
+bool sequence_writer::flush() {
+  size_t written = 0;
+
+  while(!error && written < buffer.size()) {
+    ssize_t result =
+        ::write(file, buffer.data() + written, buffer.size() - written);
+
+    // A signal interrupting the write, for example while an encoder reads
+    // the other end of a pipe, is not an error.
+    if(result < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if(result < 0) {
+      error = true;
+    } else {
+      written += (size_t)result;
+    }
+  }
+
+  buffer.clear();
+
+  return !error;
+}
+
+bool sequence_writer::close() {
+  bool success = true;
+
+  if(file >= 0) {
+    success = flush();
+
+    if(file != STDOUT_FILENO) {
+      ::close(file);
+    }
+  }
+
+  file   = -1;
+  width  = 0;
+  height = 0;
+  total  = 0;
+  error  = false;
+  buffer.clear();
+  previous.clear();
+
+  return success;
+}
+
+size_t sequence_writer::bytes() const {
+  return total;
+}
+
+bool sequence_writer::append(const uint32_t* image,
+                             int32_t         image_width,
+                             int32_t         image_height,
+                             int32_t         image_stride) {
+  if(file < 0 || error || image_width <= 0 || image_height <= 0) {
+    return false;
+  }
+
+  size_t start = buffer.size();
+
+  if(width == 0) {
+    width  = image_width;
+    height = image_height;
+
+    if(format == SEQUENCE_FORMAT_Y4M) {
+      char header[128];
+      int  length = std::snprintf(header,
+                                 sizeof(header),
+                                 "YUV4MPEG2 W%d H%d F30:1 Ip A1:1 C420jpeg "
+                                 "XCOLORRANGE=FULL\n",
+                                 width,
+                                 height);
+
+      buffer.insert(buffer.end(), header, header + length);
+    } else {
+      buffer.insert(buffer.end(), DELTA_SIGNATURE, DELTA_SIGNATURE + 4);
+      put_u32(buffer, (uint32_t)width);
+      put_u32(buffer, (uint32_t)height);
+      previous.assign((size_t)width * height, 0);
+    }
+  } else if(image_width != width || image_height != height) {
+    return false;
+  }
+
+  if(format == SEQUENCE_FORMAT_Y4M) {
+    encode_y4m(image, image_stride);
+  } else {
+    encode_delta(image, image_stride);
+  }
+
+  total += buffer.size() - start;
+
+  return buffer.size() < FLUSH_SIZE || flush();
+}
+
+// Full range BT.601 (JFIF) coefficients in 8.8 fixed point. Chroma is taken
+// from the sums of the channels of up to four pixels.
+static uint8_t luma(uint32_t pixel) {
+  uint32_t red   = pixel & 0xFF;
+  uint32_t green = (pixel >> 8) & 0xFF;
+  uint32_t blue  = (pixel >> 16) & 0xFF;
+
+  return (uint8_t)((77 * red + 150 * green + 29 * blue + 128) >> 8);
+}
+
+static uint8_t chroma(int32_t red,
+                      int32_t green,
+                      int32_t blue,
+                      int32_t count,
+                      int32_t red_weight,
+                      int32_t green_weight,
+                      int32_t blue_weight) {
+  int32_t sum = red * red_weight + green * green_weight + blue * blue_weight;
+
+  // Offset by 128 before dividing, which keeps the dividend positive and
+  // the rounding symmetric.
+  int32_t value = (sum + count * 128 + count * 256 * 128) / (count * 256);
+
+  return (uint8_t)std::clamp(value, 0, 255);
+}
+
+void sequence_writer::encode_y4m(const uint32_t* image, int32_t image_stride) {
+  static constexpr char FRAME_HEADER[] = "FRAME\n";
+
+  int32_t chroma_width  = (width + 1) / 2;
+  int32_t chroma_height = (height + 1) / 2;
+  size_t  luma_size     = (size_t)width * height;
+  size_t  chroma_size   = (size_t)chroma_width * chroma_height;
+  size_t  start         = buffer.size() + sizeof(FRAME_HEADER) - 1;
+
+  buffer.insert(buffer.end(), FRAME_HEADER, FRAME_HEADER + 6);
+  buffer.resize(start + luma_size + 2 * chroma_size);
+
+  uint8_t* plane_y  = buffer.data() + start;
+  uint8_t* plane_cb = plane_y + luma_size;
+  uint8_t* plane_cr = plane_cb + chroma_size;
+
+  for(int32_t y = 0; y < height; y++) {
+    const uint32_t* row    = image + (size_t)y * image_stride;
+    uint8_t*        output = plane_y + (size_t)y * width;
+
+    for(int32_t x = 0; x < width; x++) {
+      output[x] = luma(row[x]);
+    }
+  }
+
+  for(int32_t cy = 0; cy < chroma_height; cy++) {
+    for(int32_t cx = 0; cx < chroma_width; cx++) {
+      int32_t red   = 0;
+      int32_t green = 0;
+      int32_t blue  = 0;
+      int32_t count = 0;
+
+      for(int32_t y = cy * 2; y < std::min(cy * 2 + 2, height); y++) {
+        for(int32_t x = cx * 2; x < std::min(cx * 2 + 2, width); x++) {
+          uint32_t pixel = image[(size_t)y * image_stride + x];
+
+          red += pixel & 0xFF;
+          green += (pixel >> 8) & 0xFF;
+          blue += (pixel >> 16) & 0xFF;
+          count++;
+        }
+      }
+
+      size_t index = (size_t)cy * chroma_width + cx;
+
+      plane_cb[index] = chroma(red, green, blue, count, -43, -85, 128);
+      plane_cr[index] = chroma(red, green, blue, count, 128, -107, -21);
+    }
+  }
+}
+
+void sequence_writer::encode_delta(const uint32_t* image,
+                                   int32_t         image_stride) {
+  size_t count = (size_t)width * height;
+
+  current.resize(count);
+
+  for(int32_t y = 0; y < height; y++) {
+    std::memcpy(current.data() + (size_t)y * width,
+                image + (size_t)y * image_stride,
+                (size_t)width * sizeof(uint32_t));
+  }
+
+  // The size goes in front once the commands are known.
+  size_t size_offset = buffer.size();
+
+  put_u32(buffer, 0);
+
+  size_t          index  = 0;
+  const uint32_t* pixels = current.data();
+  const uint32_t* before = previous.data();
+
+  // The trailing skip is implied, so only the changes are written.
+  size_t end = count;
+
+  while(end > 0 && pixels[end - 1] == before[end - 1]) {
+    end--;
+  }
+
+  while(index < end) {
+    size_t next = index;
+
+    while(next < end && pixels[next] == before[next]) {
+      next++;
+    }
+
+    if(next > index) {
+      put_command(buffer, DELTA_COMMAND_SKIP, next - index);
+      index = next;
+      continue;
+    }
+
+    // A run may carry on over pixels that did not change; rewriting them
+    // with their own value costs nothing.
+    while(next < end && pixels[next] == pixels[index]) {
+      next++;
+    }
+
+    if(next - index >= MIN_RUN) {
+      put_command(buffer, DELTA_COMMAND_RUN, next - index);
+      put_pixels(buffer, pixels + index, 1);
+      index = next;
+      continue;
+    }
+
+    // Literals end at the first unchanged pixel or the start of a run.
+    next = index + 1;
+
+    while(next < end && pixels[next] != before[next] &&
+          !(next + MIN_RUN <= end && pixels[next] == pixels[next + 1] &&
+            pixels[next] == pixels[next + 2])) {
+      next++;
+    }
+
+    put_command(buffer, DELTA_COMMAND_LITERAL, next - index);
+    put_pixels(buffer, pixels + index, next - index);
+    index = next;
+  }
+
+  uint32_t size = (uint32_t)(buffer.size() - size_offset - 4);
+
+  for(size_t byte = 0; byte < 4; byte++) {
+    buffer[size_offset + byte] = (uint8_t)(size >> (byte * 8));
+  }
+
+  previous.swap(current);
+}
+
+sequence_reader::~sequence_reader() {
+  close();
+}
+
+bool sequence_reader::open(const char* filename) {
+  close();
+
+  int32_t file = ::open(filename, O_RDONLY);
+
+  if(file < 0) {
+    error = true;
+    return false;
+  }
+
+  struct stat status;
+
+  if(fstat(file, &status) != 0) {
+    ::close(file);
+    error = true;
+    return false;
+  }
+
+  size = (size_t)status.st_size;
+
+  if(size > 0) {
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+
+    if(mapping == MAP_FAILED) {
+      ::close(file);
+      size  = 0;
+      error = true;
+      return false;
+    }
+
+    data = (const uint8_t*)mapping;
+    madvise(mapping, size, MADV_SEQUENTIAL);
+  }
+
+  ::close(file);
+
+  if(size >= 12 && std::memcmp(data, DELTA_SIGNATURE, 4) == 0) {
+    format = SEQUENCE_FORMAT_DELTA;
+    width  = (int32_t)(data[4] | data[5] << 8 | data[6] << 16 | data[7] << 24);
+    height = (int32_t)(data[8] | data[9] << 8 | data[10] << 16 |
+                       data[11] << 24);
+    offset = 12;
+  } else if(size >= 10 && std::memcmp(data, Y4M_SIGNATURE, 10) == 0) {
+    format = SEQUENCE_FORMAT_Y4M;
+    offset = 10;
+
+    // Space separated parameters up to the end of the line; only the size
+    // and the chroma layout matter here.
+    // All the 4:2:0 variants differ only in chroma siting, and 4:2:0 is the
+    // default.
+    bool is_420 = true;
+
+    while(offset < size && data[offset] != '\n') {
+      size_t start = offset;
+
+      while(offset < size && data[offset] != ' ' && data[offset] != '\n') {
+        offset++;
+      }
+
+      char   token[32];
+      size_t length = std::min(offset - start, sizeof(token) - 1);
+
+      std::memcpy(token, data + start, length);
+      token[length] = '\0';
+
+      if(token[0] == 'W') {
+        width = std::atoi(token + 1);
+      } else if(token[0] == 'H') {
+        height = std::atoi(token + 1);
+      } else if(token[0] == 'C') {
+        is_420 = std::strncmp(token + 1, "420", 3) == 0;
+      }
+
+      if(offset < size && data[offset] == ' ') {
+        offset++;
+      }
+    }
+
+    offset++;
+    error = !is_420;
+  } else {
+    error = true;
+  }
+
+  if(width <= 0 || height <= 0 || width > (1 << 16) || height > (1 << 16)) {
+    error = true;
+  }
+
+  if(error) {
+    return false;
+  }
+
+  previous.assign((size_t)width * height, 0);
+
+  return true;
+}
+
+void sequence_reader::close() {
+  if(data != nullptr) {
+    munmap((void*)data, size);
+  }
+
+  data   = nullptr;
+  size   = 0;
+  offset = 0;
+  width  = 0;
+  height = 0;
+  error  = false;
+  previous.clear();
+}
+
+bool sequence_reader::failed() const {
+  return error;
+}
+
+bool sequence_reader::read(framebuffer& image) {
+  if(error || data == nullptr || offset >= size) {
+    return false;
+  }
+
+  if(image.width() != width || image.height() != height) {
+    image = framebuffer(width, height);
+  }
+
+  bool success = format == SEQUENCE_FORMAT_Y4M ? read_y4m(image)
+                                               : read_delta(image);
+
+  error = !success;
+
+  return success;
+}
+
+static uint8_t clamp_channel(int32_t value) {
+  return (uint8_t)std::clamp((value + 32768) >> 16, 0, 255);
+}
+
+bool sequence_reader::read_y4m(framebuffer& image) {
+  if(size - offset < 6 || std::memcmp(data + offset, "FRAME", 5) != 0) {
+    return false;
+  }
+
+  const uint8_t* line_end =
+      (const uint8_t*)std::memchr(data + offset, '\n', size - offset);
+
+  if(line_end == nullptr) {
+    return false;
+  }
+
+  offset = (size_t)(line_end - data) + 1;
+
+  int32_t chroma_width  = (width + 1) / 2;
+  int32_t chroma_height = (height + 1) / 2;
+  size_t  luma_size     = (size_t)width * height;
+  size_t  chroma_size   = (size_t)chroma_width * chroma_height;
+
+  if(size - offset < luma_size + 2 * chroma_size) {
+    return false;
+  }
+
+  const uint8_t* plane_y  = data + offset;
+  const uint8_t* plane_cb = plane_y + luma_size;
+  const uint8_t* plane_cr = plane_cb + chroma_size;
+
+  // The inverse of the writer's transform in 16.16 fixed point; chroma is
+  // repeated over its 2x2 pixels.
+  for(int32_t y = 0; y < height; y++) {
+    uint32_t* output = image.row(y);
+
+    for(int32_t x = 0; x < width; x++) {
+      size_t  index = (size_t)(y / 2) * chroma_width + x / 2;
+      int32_t level = plane_y[(size_t)y * width + x] << 16;
+      int32_t cb    = plane_cb[index] - 128;
+      int32_t cr    = plane_cr[index] - 128;
+
+      output[x] = pack_color(clamp_channel(level + 91881 * cr),
+                             clamp_channel(level - 22554 * cb - 46802 * cr),
+                             clamp_channel(level + 116130 * cb),
+                             255);
+    }
+  }
+
+  offset += luma_size + 2 * chroma_size;
+
+  return true;
+}
+
+static bool get_varint(const uint8_t* data,
+                       size_t         size,
+                       size_t&        offset,
+                       uint64_t&      value) {
+  value = 0;
+
+  for(int32_t shift = 0; shift < 64; shift += 7) {
+    if(offset >= size) {
+      return false;
+    }
+
+    uint8_t byte = data[offset++];
+
+    value |= (uint64_t)(byte & 0x7F) << shift;
+
+    if((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool sequence_reader::read_delta(framebuffer& image) {
+  if(size - offset < 4) {
+    return false;
+  }
+
+  const uint8_t* header = data + offset;
+  size_t frame_size = header[0] | header[1] << 8 | header[2] << 16 |
+                      (size_t)header[3] << 24;
+
+  offset += 4;
+
+  if(size - offset < frame_size) {
+    return false;
+  }
+
+  const uint8_t* commands = data + offset;
+  size_t         position = 0;
+  size_t         index    = 0;
+  size_t         count    = previous.size();
+  uint32_t*      pixels   = previous.data();
+
+  offset += frame_size;
+
+  while(position < frame_size) {
+    uint64_t command;
+
+    if(!get_varint(commands, frame_size, position, command)) {
+      return false;
+    }
+
+    uint64_t length = command >> 2;
+    uint64_t kind   = command & 3;
+
+    if(length > count - index) {
+      return false;
+    }
+
+    if(kind == DELTA_COMMAND_RUN) {
+      if(frame_size - position < 4) {
+        return false;
+      }
+
+      uint32_t pixel;
+
+      std::memcpy(&pixel, commands + position, 4);
+      std::fill(pixels + index, pixels + index + length, pixel);
+      position += 4;
+    } else if(kind == DELTA_COMMAND_LITERAL) {
+      if((frame_size - position) / 4 < length) {
+        return false;
+      }
+
+      std::memcpy(pixels + index, commands + position, length * 4);
+      position += length * 4;
+    } else if(kind != DELTA_COMMAND_SKIP) {
+      return false;
+    }
+
+    index += length;
+  }
+
+  for(int32_t y = 0; y < height; y++) {
+    std::memcpy(image.row(y),
+                pixels + (size_t)y * width,
+                (size_t)width * sizeof(uint32_t));
+  }
+
+  return true;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "framebuffer.h"
+
+enum sequence_format_e {
+  // YUV4MPEG2, 4:2:0 full range BT.601, for piping into a video encoder.
+  // Lossy: chroma is averaged over 2x2 pixels and alpha is dropped.
+  SEQUENCE_FORMAT_Y4M,
+  // Lossless delta-RLE container; see sequence_writer.
+  SEQUENCE_FORMAT_DELTA,
+};
+
+// Picks the format from the extension of filename (.y4m or .drle, in any
+// case) and falls back to fallback for anything else, "-" included.
+sequence_format_e sequence_format_for_filename(const char*       filename,
+                                               sequence_format_e fallback);
+
+// Whether filename has one of the extensions above.
+bool is_sequence_filename(const char* filename);
+
+// Appends frames of one size to a single file, or to standard output for
+// the filename "-". Encoded frames collect in a buffer that goes out in one
+// write whenever it passes a megabyte, so a sequence costs a handful of
+// system calls instead of an open, a write and a close per frame.
+//
+// The delta format stores only what changed since the previous frame. All
+// integers are little-endian:
+//
+//   "DRLE" width:u32 height:u32
+//   per frame: size:u32, then size bytes of commands
+//
+// A command is a LEB128 varint holding (count << 2) | kind:
+//
+//   0 skip     the next count pixels keep their previous value
+//   1 run      the next count pixels take the 4 byte pixel that follows
+//   2 literal  count 4 byte pixels follow
+//
+// Commands cover the frame in raster order and pixels after the last one
+// are unchanged. Pixels are in pack_color byte order, and the frame before
+// the first one is all zero.
+class sequence_writer {
+  public:
+    explicit sequence_writer(sequence_format_e format = SEQUENCE_FORMAT_DELTA);
+    ~sequence_writer();
+
+    sequence_writer(const sequence_writer&)            = delete;
+    sequence_writer& operator=(const sequence_writer&) = delete;
+
+    bool open(const char* filename);
+
+    // Fails once the file could not be written, and for frames whose size
+    // differs from the first one.
+    bool append(const uint32_t* image,
+                int32_t         image_width,
+                int32_t         image_height,
+                int32_t         image_stride);
+
+    // Writes out what is still buffered. Returns whether every write
+    // succeeded.
+    bool close();
+
+    // Bytes handed to the file so far, buffered ones included.
+    size_t bytes() const;
+
+  private:
+    bool flush();
+    void encode_y4m(const uint32_t* image, int32_t image_stride);
+    void encode_delta(const uint32_t* image, int32_t image_stride);
+
+    sequence_format_e     format;
+    std::vector<uint8_t>  buffer;
+    std::vector<uint32_t> previous;
+    std::vector<uint32_t> current;
+    int32_t               file   = -1;
+    int32_t               width  = 0;
+    int32_t               height = 0;
+    size_t                total  = 0;
+    bool                  error  = false;
+};
+
+// Reads sequences written by sequence_writer in either format, telling them
+// apart by their signature. Y4M files come back converted to packed pixels
+// with opaque alpha. The file is mapped rather than read.
+class sequence_reader {
+  public:
+    sequence_reader() = default;
+    ~sequence_reader();
+
+    sequence_reader(const sequence_reader&)            = delete;
+    sequence_reader& operator=(const sequence_reader&) = delete;
+
+    bool open(const char* filename);
+    void close();
+
+    // Decodes the next frame into image, reallocating it only when the size
+    // changes. Returns false at the end of the file and on malformed input;
+    // failed() tells the two apart.
+    bool read(framebuffer& image);
+
+    bool failed() const;
+
+  private:
+    bool read_y4m(framebuffer& image);
+    bool read_delta(framebuffer& image);
+
+    const uint8_t*        data   = nullptr;
+    size_t                size   = 0;
+    size_t                offset = 0;
+    sequence_format_e     format = SEQUENCE_FORMAT_DELTA;
+    std::vector<uint32_t> previous;
+    int32_t               width  = 0;
+    int32_t               height = 0;
+    bool                  error  = false;
+};
@@ -0,0 +1,134 @@
+#include "thread_pool.h"
+
+thread_pool::thread_pool(size_t thread_count)
+  : queue_count{ thread_count == 0 ? 1 : thread_count }
+  , queues{ new queue_s[queue_count] } {
+  for(size_t index = 1; index < queue_count; index++) {
+    threads.emplace_back(&thread_pool::worker, this, index);
+  }
+}
+
+thread_pool::~thread_pool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+
+  wake.notify_all();
+
+  for(std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+size_t thread_pool::size() const {
+  return queue_count;
+}
+
+size_t thread_pool::default_thread_count() {
+  size_t count = std::thread::hardware_concurrency();
+  return count == 0 ? 1 : count;
+}
+
+void thread_pool::parallel_for(size_t                             count,
+                               const std::function<void(size_t)>& function) {
+  if(count == 0) {
+    return;
+  }
+
+  if(queue_count == 1) {
+    for(size_t index = 0; index < count; index++) {
+      function(index);
+    }
+
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->function = &function;
+    pending        = count;
+  }
+
+  for(size_t index = 0; index < count; index++) {
+    queue_s&                    queue = queues[index % queue_count];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.indices.push_back(index);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    generation++;
+  }
+
+  wake.notify_all();
+
+  drain(0);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  done.wait(lock, [this] {
+    return pending == 0;
+  });
+  this->function = nullptr;
+}
+
+bool thread_pool::pop(size_t worker_index, size_t& index) {
+  {
+    queue_s&                    own = queues[worker_index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+
+    if(!own.indices.empty()) {
+      index = own.indices.back();
+      own.indices.pop_back();
+      return true;
+    }
+  }
+
+  for(size_t offset = 1; offset < queue_count; offset++) {
+    queue_s& victim = queues[(worker_index + offset) % queue_count];
+
+    std::lock_guard<std::mutex> lock(victim.mutex);
+
+    if(!victim.indices.empty()) {
+      index = victim.indices.front();
+      victim.indices.pop_front();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void thread_pool::drain(size_t worker_index) {
+  size_t index = 0;
+
+  while(pop(worker_index, index)) {
+    (*function)(index);
+
+    if(pending.fetch_sub(1) == 1) {
+      std::lock_guard<std::mutex> lock(mutex);
+      done.notify_all();
+    }
+  }
+}
+
+void thread_pool::worker(size_t worker_index) {
+  uint64_t seen = 0;
+
+  while(true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wake.wait(lock, [this, seen] {
+        return stopping || generation != seen;
+      });
+
+      if(stopping) {
+        return;
+      }
+
+      seen = generation;
+    }
+
+    drain(worker_index);
+  }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fork-join pool with one deque per worker. parallel_for deals the indices
+// out round-robin, each worker drains its own deque from the back and steals
+// from the front of the others once it runs dry. The calling thread takes
+// part as worker zero, so a pool of size one runs everything inline.
+class thread_pool {
+  public:
+    explicit thread_pool(size_t thread_count = default_thread_count());
+    ~thread_pool();
+
+    thread_pool(const thread_pool&)            = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    size_t size() const;
+
+    // Runs function(index) for every index in [0, count) and returns once all
+    // of them have finished. Not reentrant: function must not call back into
+    // the same pool.
+    void parallel_for(size_t                             count,
+                      const std::function<void(size_t)>& function);
+
+    static size_t default_thread_count();
+
+  private:
+    struct queue_s {
+        std::mutex         mutex;
+        std::deque<size_t> indices;
+    };
+
+    bool pop(size_t worker_index, size_t& index);
+    void drain(size_t worker_index);
+    void worker(size_t worker_index);
+
+    size_t                     queue_count;
+    std::unique_ptr<queue_s[]> queues;
+    std::vector<std::thread>   threads;
+
+    std::mutex                         mutex;
+    std::condition_variable            wake;
+    std::condition_variable            done;
+    const std::function<void(size_t)>* function   = nullptr;
+    uint64_t                           generation = 0;
+    bool                               stopping   = false;
+    std::atomic<size_t>                pending    = 0;
+};
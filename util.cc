@@ -1,6 +1,13 @@
 #include "util.h"
 
-#include <fstream>
+#include <cstring>
+
+#if defined(__x86_64__)
+# include <immintrin.h>
+#endif
+
+#include "framebuffer_fill.h"
+#include "image_writer.h"
 
 uint32_t pack_color(const uint8_t red,
                     const uint8_t green,
@@ -14,40 +21,307 @@ void unpack_color(const uint32_t color,
                   uint8_t*       g,
                   uint8_t*       b,
                   uint8_t*       a) {
-  *r = (color >> 0) * 255;
-  *g = (color >> 8) * 255;
-  *b = (color >> 16) * 255;
-  *a = (color >> 24) * 255;
+  *r = (color >> 0) & 0xFF;
+  *g = (color >> 8) & 0xFF;
+  *b = (color >> 16) & 0xFF;
+  *a = (color >> 24) & 0xFF;
 }
 
-void clear_framebuffer(uint32_t* image, int32_t image_width, int32_t image_height) {
-  for(int32_t index_y = 0; index_y < image_height; index_y++) {
-    for(int32_t index_x = 0; index_x < image_width; index_x++) {
-      image[index_x + index_y * image_width] = pack_color(0, 0, 0, 255);
+// Packed pixels are r, g, b, a in memory on little endian hosts, so the
+// interleaved conversions are plain copies there.
+void pack_colors(uint32_t* colors, const uint8_t* rgba, size_t count) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  std::memcpy(colors, rgba, count * 4);
+#else
+  for(size_t index = 0; index < count; index++) {
+    const uint8_t* pixel = rgba + index * 4;
+
+    colors[index] = pack_color(pixel[0], pixel[1], pixel[2], pixel[3]);
+  }
+#endif
+}
+
+void unpack_colors(uint8_t* rgba, const uint32_t* colors, size_t count) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  std::memcpy(rgba, colors, count * 4);
+#else
+  for(size_t index = 0; index < count; index++) {
+    uint8_t* pixel = rgba + index * 4;
+
+    unpack_color(colors[index], &pixel[0], &pixel[1], &pixel[2], &pixel[3]);
+  }
+#endif
+}
+
+static constexpr float INVERSE_255 = 1.0f / 255.0f;
+
+// NaN and negative values become 0, so this matches the min/max sequence the
+// vector paths use.
+static uint32_t float_to_channel(float value) {
+  float clamped = value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f;
+  return (uint32_t)(clamped * 255.0f + 0.5f);
+}
+
+void pack_colors_float_scalar(uint32_t*    colors,
+                              const float* red,
+                              const float* green,
+                              const float* blue,
+                              const float* alpha,
+                              size_t       count) {
+  for(size_t index = 0; index < count; index++) {
+    uint32_t a = alpha != nullptr ? float_to_channel(alpha[index]) : 255;
+
+    colors[index] = float_to_channel(red[index]) |
+                    (float_to_channel(green[index]) << 8) |
+                    (float_to_channel(blue[index]) << 16) | (a << 24);
+  }
+}
+
+void unpack_colors_float_scalar(float*          red,
+                                float*          green,
+                                float*          blue,
+                                float*          alpha,
+                                const uint32_t* colors,
+                                size_t          count) {
+  for(size_t index = 0; index < count; index++) {
+    uint32_t color = colors[index];
+
+    red[index]   = ((color >> 0) & 0xFF) * INVERSE_255;
+    green[index] = ((color >> 8) & 0xFF) * INVERSE_255;
+    blue[index]  = ((color >> 16) & 0xFF) * INVERSE_255;
+
+    if(alpha != nullptr) {
+      alpha[index] = ((color >> 24) & 0xFF) * INVERSE_255;
+    }
+  }
+}
+
+#if defined(__x86_64__)
+
+# define TARGET_AVX2 __attribute__((target("avx2")))
+
+static inline __m128i float_to_channel_sse2(const float* values) {
+  __m128 value = _mm_loadu_ps(values);
+
+  value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+  value = _mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f));
+
+  return _mm_cvttps_epi32(value);
+}
+
+static size_t pack_colors_float_sse2(uint32_t*    colors,
+                                     const float* red,
+                                     const float* green,
+                                     const float* blue,
+                                     const float* alpha,
+                                     size_t       count) {
+  size_t index = 0;
+
+  for(; index + 4 <= count; index += 4) {
+    __m128i r = float_to_channel_sse2(red + index);
+    __m128i g = float_to_channel_sse2(green + index);
+    __m128i b = float_to_channel_sse2(blue + index);
+    __m128i a = alpha != nullptr ? float_to_channel_sse2(alpha + index)
+                                 : _mm_set1_epi32(255);
+
+    __m128i color = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)),
+                                 _mm_or_si128(_mm_slli_epi32(b, 16),
+                                              _mm_slli_epi32(a, 24)));
+
+    _mm_storeu_si128((__m128i*)(colors + index), color);
+  }
+
+  return index;
+}
+
+static inline void channel_to_float_sse2(float* values, __m128i channel) {
+  __m128 value = _mm_cvtepi32_ps(_mm_and_si128(channel, _mm_set1_epi32(0xFF)));
+  _mm_storeu_ps(values, _mm_mul_ps(value, _mm_set1_ps(INVERSE_255)));
+}
+
+static size_t unpack_colors_float_sse2(float*          red,
+                                       float*          green,
+                                       float*          blue,
+                                       float*          alpha,
+                                       const uint32_t* colors,
+                                       size_t          count) {
+  size_t index = 0;
+
+  for(; index + 4 <= count; index += 4) {
+    __m128i color = _mm_loadu_si128((const __m128i*)(colors + index));
+
+    channel_to_float_sse2(red + index, color);
+    channel_to_float_sse2(green + index, _mm_srli_epi32(color, 8));
+    channel_to_float_sse2(blue + index, _mm_srli_epi32(color, 16));
+
+    if(alpha != nullptr) {
+      channel_to_float_sse2(alpha + index, _mm_srli_epi32(color, 24));
     }
   }
+
+  return index;
+}
+
+TARGET_AVX2 static inline __m256i float_to_channel_avx2(const float* values) {
+  __m256 value = _mm256_loadu_ps(values);
+
+  value = _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()),
+                        _mm256_set1_ps(1.0f));
+  value = _mm256_add_ps(_mm256_mul_ps(value, _mm256_set1_ps(255.0f)),
+                        _mm256_set1_ps(0.5f));
+
+  return _mm256_cvttps_epi32(value);
+}
+
+TARGET_AVX2 static size_t pack_colors_float_avx2(uint32_t*    colors,
+                                                 const float* red,
+                                                 const float* green,
+                                                 const float* blue,
+                                                 const float* alpha,
+                                                 size_t       count) {
+  size_t index = 0;
+
+  for(; index + 8 <= count; index += 8) {
+    __m256i r = float_to_channel_avx2(red + index);
+    __m256i g = float_to_channel_avx2(green + index);
+    __m256i b = float_to_channel_avx2(blue + index);
+    __m256i a = alpha != nullptr ? float_to_channel_avx2(alpha + index)
+                                 : _mm256_set1_epi32(255);
+
+    __m256i color =
+        _mm256_or_si256(_mm256_or_si256(r, _mm256_slli_epi32(g, 8)),
+                        _mm256_or_si256(_mm256_slli_epi32(b, 16),
+                                        _mm256_slli_epi32(a, 24)));
+
+    _mm256_storeu_si256((__m256i*)(colors + index), color);
+  }
+
+  return index;
+}
+
+TARGET_AVX2 static inline void channel_to_float_avx2(float*  values,
+                                                     __m256i channel) {
+  __m256 value = _mm256_cvtepi32_ps(
+      _mm256_and_si256(channel, _mm256_set1_epi32(0xFF)));
+  _mm256_storeu_ps(values, _mm256_mul_ps(value, _mm256_set1_ps(INVERSE_255)));
+}
+
+TARGET_AVX2 static size_t unpack_colors_float_avx2(float*          red,
+                                                   float*          green,
+                                                   float*          blue,
+                                                   float*          alpha,
+                                                   const uint32_t* colors,
+                                                   size_t          count) {
+  size_t index = 0;
+
+  for(; index + 8 <= count; index += 8) {
+    __m256i color = _mm256_loadu_si256((const __m256i*)(colors + index));
+
+    channel_to_float_avx2(red + index, color);
+    channel_to_float_avx2(green + index, _mm256_srli_epi32(color, 8));
+    channel_to_float_avx2(blue + index, _mm256_srli_epi32(color, 16));
+
+    if(alpha != nullptr) {
+      channel_to_float_avx2(alpha + index, _mm256_srli_epi32(color, 24));
+    }
+  }
+
+  return index;
+}
+
+#endif
+
+void pack_colors_float(uint32_t*    colors,
+                       const float* red,
+                       const float* green,
+                       const float* blue,
+                       const float* alpha,
+                       size_t       count) {
+  size_t index = 0;
+
+#if defined(__x86_64__)
+  if(__builtin_cpu_supports("avx2")) {
+    index = pack_colors_float_avx2(colors, red, green, blue, alpha, count);
+  } else {
+    index = pack_colors_float_sse2(colors, red, green, blue, alpha, count);
+  }
+#endif
+
+  pack_colors_float_scalar(colors + index,
+                           red + index,
+                           green + index,
+                           blue + index,
+                           alpha != nullptr ? alpha + index : nullptr,
+                           count - index);
+}
+
+void unpack_colors_float(float*          red,
+                         float*          green,
+                         float*          blue,
+                         float*          alpha,
+                         const uint32_t* colors,
+                         size_t          count) {
+  size_t index = 0;
+
+#if defined(__x86_64__)
+  if(__builtin_cpu_supports("avx2")) {
+    index = unpack_colors_float_avx2(red, green, blue, alpha, colors, count);
+  } else {
+    index = unpack_colors_float_sse2(red, green, blue, alpha, colors, count);
+  }
+#endif
+
+  unpack_colors_float_scalar(red + index,
+                             green + index,
+                             blue + index,
+                             alpha != nullptr ? alpha + index : nullptr,
+                             colors + index,
+                             count - index);
+}
+
+void clear_framebuffer(uint32_t* image, int32_t image_width, int32_t image_height) {
+  fill_pixels(image,
+              (size_t)image_width * image_height,
+              pack_color(0, 0, 0, 255));
 }
 
 void write_framebuffer(const char*     filename,
                        const uint32_t* image,
                        const int32_t   image_width,
                        const int32_t   image_height) {
-  std::ofstream ofs(filename, std::ios::binary);
-  ofs << "P6" << std::endl
-      << image_width << " " << image_height << std::endl
-      << "255" << std::endl;
+  framebuffer_view_t view{ (uint32_t*)image,
+                           image_width,
+                           image_height,
+                           image_width };
 
-  for(int32_t index = 0; index < (image_width * image_height); index++) {
-    uint8_t red   = 0;
-    uint8_t green = 0;
-    uint8_t blue  = 0;
-    uint8_t alpha = 0;
+  write_framebuffer_view(filename, view);
+}
 
-    unpack_color(image[index], &red, &green, &blue, &alpha);
+void clear_framebuffer_view(framebuffer_view_t view) {
+  fill_rect(view.pixels,
+            view.stride,
+            view.height,
+            0,
+            0,
+            view.width,
+            view.height,
+            pack_color(0, 0, 0, 255));
+}
 
-    ofs << static_cast<char>(red) << static_cast<char>(green)
-        << static_cast<char>(blue);
-  }
+void write_framebuffer_view(const char* filename, framebuffer_view_t view) {
+  // Indexed by image_format_e, so every format keeps its own buffer.
+  static thread_local image_writer writers[] = {
+    image_writer{ IMAGE_FORMAT_PPM },
+    image_writer{ IMAGE_FORMAT_PAM },
+    image_writer{ IMAGE_FORMAT_QOI },
+    image_writer{ IMAGE_FORMAT_PNG },
+  };
+
+  image_format_e format = image_format_for_filename(filename, IMAGE_FORMAT_PPM);
 
-  ofs.close();
+  writers[format].write(filename,
+                        view.pixels,
+                        view.width,
+                        view.height,
+                        view.stride);
 }
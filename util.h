@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 #define SIGNATURE_8(ValueA) (ValueA)
@@ -22,6 +23,14 @@
 extern "C" {
 #endif
 
+  // Pixels of a framebuffer whose rows are stride pixels apart.
+  typedef struct framebuffer_view_t {
+      uint32_t* pixels;
+      int32_t   width;
+      int32_t   height;
+      int32_t   stride;
+  } framebuffer_view_t;
+
   uint32_t pack_color(const uint8_t red,
                       const uint8_t green,
                       const uint8_t blue,
@@ -33,13 +42,57 @@ extern "C" {
                     uint8_t*       b,
                     uint8_t*       a);
 
+  // Batch conversions between packed pixels (as built by pack_color),
+  // interleaved 8-bit RGBA and planar float channels in [0, 1]. Floats are
+  // clamped and rounded to the nearest 8-bit value, so float -> packed ->
+  // float -> packed round-trips exactly. A null alpha plane packs as opaque
+  // and is skipped when unpacking. The _scalar variants are the reference the
+  // SSE2/AVX2 paths are checked against.
+  void pack_colors(uint32_t* colors, const uint8_t* rgba, size_t count);
+
+  void unpack_colors(uint8_t* rgba, const uint32_t* colors, size_t count);
+
+  void pack_colors_float(uint32_t*    colors,
+                         const float* red,
+                         const float* green,
+                         const float* blue,
+                         const float* alpha,
+                         size_t       count);
+
+  void unpack_colors_float(float*          red,
+                           float*          green,
+                           float*          blue,
+                           float*          alpha,
+                           const uint32_t* colors,
+                           size_t          count);
+
+  void pack_colors_float_scalar(uint32_t*    colors,
+                                const float* red,
+                                const float* green,
+                                const float* blue,
+                                const float* alpha,
+                                size_t       count);
+
+  void unpack_colors_float_scalar(float*          red,
+                                  float*          green,
+                                  float*          blue,
+                                  float*          alpha,
+                                  const uint32_t* colors,
+                                  size_t          count);
+
   void clear_framebuffer(uint32_t* image, int32_t image_width, int32_t image_height);
 
+  // The format follows the extension of filename: .pam, .qoi and .png are
+  // written as such, anything else as binary PPM.
   void write_framebuffer(const char*     filename,
                          const uint32_t* image,
                          const int32_t   image_width,
                          const int32_t   image_height);
 
+  void clear_framebuffer_view(framebuffer_view_t view);
+
+  void write_framebuffer_view(const char* filename, framebuffer_view_t view);
+
 #if defined(__cplusplus)
 }
 #endif